@@ -0,0 +1,67 @@
+#include "Bench.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+
+using namespace bench;
+
+// Every allocation carries a header holding its size, so frees can be subtracted from the live
+// total. The header is max_align_t sized to keep the returned pointer suitably aligned.
+static constexpr size_t kHeader = alignof(std::max_align_t);
+
+static std::atomic<size_t> g_count{0}, g_bytes{0}, g_live{0}, g_peak{0};
+
+void *operator new(size_t size) {
+  char *p = static_cast<char *>(std::malloc(size + kHeader));
+  if (!p) throw std::bad_alloc{};
+  *reinterpret_cast<size_t *>(p) = size;
+
+  g_count.fetch_add(1, std::memory_order_relaxed);
+  g_bytes.fetch_add(size, std::memory_order_relaxed);
+  size_t live = g_live.fetch_add(size, std::memory_order_relaxed) + size;
+  size_t peak = g_peak.load(std::memory_order_relaxed);
+  while (live > peak && !g_peak.compare_exchange_weak(peak, live, std::memory_order_relaxed)) {}
+  return p + kHeader;
+}
+
+void operator delete(void *ptr) noexcept {
+  if (!ptr) return;
+  char *p = static_cast<char *>(ptr) - kHeader;
+  g_live.fetch_sub(*reinterpret_cast<size_t *>(p), std::memory_order_relaxed);
+  std::free(p);
+}
+
+void operator delete(void *ptr, size_t) noexcept { operator delete(ptr); }
+
+AllocationStats bench::GetAllocationStats() {
+  return AllocationStats{ g_count.load(), g_bytes.load(), g_live.load(), g_peak.load() };
+}
+
+void bench::ResetPeak() {
+  g_peak.store(g_live.load());
+}
+
+void Reporter::Report(const Result &result) {
+  _out << std::setprecision(6) << "{\"benchmark\": \"" << result.name << "\"";
+  for (auto &[key, value] : result.params)
+    _out << ", \"" << key << "\": " << value;
+  _out << ", \"ops\": " << result.ops << ", \"ns_per_op\": " << result.nsPerOp;
+  if (result.expansionsPerOp > 0) {
+    _out << ", \"expansions_per_op\": " << result.expansionsPerOp
+         << ", \"ns_per_expansion\": " << result.nsPerOp / result.expansionsPerOp;
+  }
+  _out << ", \"allocations_per_op\": " << result.allocationsPerOp << ", \"bytes_per_op\": " << result.bytesPerOp
+       << ", \"peak_bytes\": " << result.peakBytes << "}" << std::endl;
+}
+
+std::vector<Benchmark> &bench::Registry() {
+  static std::vector<Benchmark> registry;
+  return registry;
+}
+
+int bench::Register(std::string name, BenchmarkFn fn) {
+  Registry().push_back(Benchmark{ std::move(name), std::move(fn) });
+  return (int)Registry().size();
+}
@@ -0,0 +1,346 @@
+#include "Bench.h"
+#include "Grid.h"
+#include "GridTestUtil.h"
+#include "grid/HierarchicalPlanner.h"
+
+#include <units/length.h>
+#include <units/time.h>
+
+#include <algorithm>
+#include <random>
+
+// Grids come from the test fixtures (RandomGrid etc.). The same seed is used for every run, so
+// results are comparable between commits.
+static const int kSizes[] = { 64, 128, 256, 512 };
+static const double kDensities[] = { 0.0, 0.1, 0.2, 0.3 };
+static const int kQueries = 16;
+
+static Eigen::Vector2i RandomCell(std::mt19937 &rng, grid_t &grid, int size, bool free) {
+  std::uniform_int_distribution<int> coord{0, size - 1};
+  Eigen::Vector2i idx;
+  do {
+    idx = { coord(rng), coord(rng) };
+  } while (free && grid.Get(idx));
+  return idx;
+}
+
+struct Query {
+  Eigen::Vector2i start, end;
+  size_t expansions;
+};
+
+// Queries between random cells at least half the grid apart. The expansion count for each is found
+// up front with a workspace search, which runs the same search as the deque-returning calls.
+static std::vector<Query> MakeQueries(std::mt19937 &rng, grid_t &grid, int size, bool strict) {
+  cost_per_m_t cost{1};
+  wom::GridSearchWorkspace workspace;
+  std::vector<grid_t::GridPathNode<units::second>> path;
+  std::vector<Query> queries;
+  while ((int)queries.size() < kQueries) {
+    Query q{ RandomCell(rng, grid, size, strict), RandomCell(rng, grid, size, strict), 0 };
+    if ((q.start - q.end).cast<double>().norm() < size / 2) continue;
+    grid.AStar<units::second>(q.start, q.end, cost, cost, workspace, path);
+    q.expansions = workspace.GetExpansions();
+    queries.push_back(q);
+  }
+  return queries;
+}
+
+template<typename F>
+static void ForEachConfiguration(F &&f) {
+  for (int size : kSizes) {
+    for (double density : kDensities) {
+      std::mt19937 rng{4788};
+      grid_t grid = RandomGrid(rng, size, density);
+      f(rng, grid, size, density);
+    }
+  }
+}
+
+BENCHMARK(GridAStar) {
+  cost_per_m_t cost{1};
+  ForEachConfiguration([&](std::mt19937 &rng, grid_t &grid, int size, double density) {
+    auto queries = MakeQueries(rng, grid, size, false);
+    size_t i = 0;
+    reporter.Measure("GridAStar", { { "size", size }, { "density", density } }, [&]() {
+      const Query &q = queries[i++ % queries.size()];
+      grid.AStar<units::second>(q.start, q.end, cost, cost);
+      return q.expansions;
+    });
+  });
+}
+
+BENCHMARK(GridAStarStrict) {
+  cost_per_m_t cost{1};
+  ForEachConfiguration([&](std::mt19937 &rng, grid_t &grid, int size, double density) {
+    auto queries = MakeQueries(rng, grid, size, true);
+    size_t i = 0;
+    reporter.Measure("GridAStarStrict", { { "size", size }, { "density", density } }, [&]() {
+      const Query &q = queries[i++ % queries.size()];
+      grid.AStarStrict<units::second>(q.start, q.end, cost, cost);
+      return q.expansions;
+    });
+
+    // The allocation-free overload, for comparison.
+    wom::GridSearchWorkspace workspace;
+    std::vector<grid_t::GridPathNode<units::second>> path;
+    reporter.Measure("GridAStarStrictWorkspace", { { "size", size }, { "density", density } }, [&]() {
+      const Query &q = queries[i++ % queries.size()];
+      grid.AStarStrict<units::second>(q.start, q.end, cost, cost, workspace, path);
+      return q.expansions;
+    });
+  });
+}
+
+// The original shared_ptr / linear-scan search against AStarStrict on the same queries. The legacy
+// search is quadratic in the cells it touches, so only small grids are run.
+BENCHMARK(GridAStarLegacy) {
+  cost_per_m_t cost{1};
+  for (int size : { 32, 64 }) {
+    for (double density : { 0.0, 0.2 }) {
+      std::mt19937 rng{4788};
+      grid_t grid = RandomGrid(rng, size, density);
+      auto queries = MakeQueries(rng, grid, size, true);
+
+      size_t i = 0;
+      reporter.Measure("GridAStarLegacy", { { "size", size }, { "density", density } }, [&]() {
+        const Query &q = queries[i++ % queries.size()];
+        LegacyAStarStrict(grid, q.start, q.end, cost, cost);
+        return q.expansions;
+      });
+      i = 0;
+      reporter.Measure("GridAStarHeap", { { "size", size }, { "density", density } }, [&]() {
+        const Query &q = queries[i++ % queries.size()];
+        grid.AStarStrict<units::second>(q.start, q.end, cost, cost);
+        return q.expansions;
+      });
+    }
+  }
+}
+
+// JPS against A* on the same strict queries, over maps with long open runs (empty, field) and over
+// a maze, where nearly every junction is a jump point. The map is reported as 0 = empty, 1 = maze,
+// 2 = field.
+BENCHMARK(GridJPS) {
+  cost_per_m_t cost{1};
+  for (int size : kSizes) {
+    std::mt19937 rng{4788};
+    grid_t maps[] = {
+      grid_t{ 0_m, size * 1_m, 0_m, size * 1_m, (size_t)size, (size_t)size },
+      MazeGrid(rng, size),
+      FieldGrid(size)
+    };
+    for (int map = 0; map < 3; map++) {
+      grid_t &grid = maps[map];
+      auto queries = MakeQueries(rng, grid, size, true);
+
+      wom::GridSearchWorkspace workspace;
+      std::vector<grid_t::GridPathNode<units::second>> path;
+      std::vector<size_t> jpsExpansions;
+      for (const Query &q : queries) {
+        grid.JPSStrict<units::second>(q.start, q.end, cost, cost, workspace, path);
+        jpsExpansions.push_back(workspace.GetExpansions());
+      }
+
+      size_t i = 0;
+      reporter.Measure("GridJPSAStar", { { "size", size }, { "map", map } }, [&]() {
+        const Query &q = queries[i++ % queries.size()];
+        grid.AStarStrict<units::second>(q.start, q.end, cost, cost, workspace, path);
+        return q.expansions;
+      });
+      i = 0;
+      reporter.Measure("GridJPS", { { "size", size }, { "map", map } }, [&]() {
+        size_t n = i++ % queries.size();
+        grid.JPSStrict<units::second>(queries[n].start, queries[n].end, cost, cost, workspace, path);
+        return jpsExpansions[n];
+      });
+    }
+  }
+}
+
+// HPA* against AStarStrict on the same queries. HPA* paths are near-optimal, so the mean and worst
+// ratio of its path cost to the optimal cost are reported alongside the timing. Expansions are
+// abstract nodes for HPA*.
+BENCHMARK(GridHierarchical) {
+  cost_per_m_t cost{1};
+  ForEachConfiguration([&](std::mt19937 &rng, grid_t &grid, int size, double density) {
+    auto queries = MakeQueries(rng, grid, size, true);
+    wom::HierarchicalPlanner<grid_t, units::second> planner{ grid, cost, cost };
+    // Build the abstract graph up front, otherwise the first query pays for it.
+    planner.GetAbstractNodeCount();
+
+    double total = 0, worst = 0;
+    int found = 0;
+    for (const Query &q : queries) {
+      auto path = planner.PlanStrict(q.start, q.end);
+      auto expected = grid.AStarStrict<units::second>(q.start, q.end, cost, cost);
+      if (path.empty() || expected.empty() || expected.back().cost.value() == 0) continue;
+      double ratio = path.back().cost.value() / expected.back().cost.value();
+      total += ratio;
+      worst = std::max(worst, ratio);
+      found++;
+    }
+    double mean = found > 0 ? total / found : 0;
+
+    size_t i = 0;
+    reporter.Measure("GridHierarchicalAStar", { { "size", size }, { "density", density } }, [&]() {
+      const Query &q = queries[i++ % queries.size()];
+      grid.AStarStrict<units::second>(q.start, q.end, cost, cost);
+      return q.expansions;
+    });
+    i = 0;
+    reporter.Measure("GridHierarchical", { { "size", size }, { "density", density }, { "mean_cost_ratio", mean }, { "worst_cost_ratio", worst } }, [&]() {
+      const Query &q = queries[i++ % queries.size()];
+      planner.PlanStrict(q.start, q.end);
+      return planner.GetExpansions();
+    });
+  });
+}
+
+// Theta* against AStarStrict, and against AStarStrict followed by Shortcut smoothing, on the same
+// queries. The mean ratio of each path's cost to the A* path cost is reported with the timing.
+BENCHMARK(GridThetaStar) {
+  cost_per_m_t cost{1};
+  ForEachConfiguration([&](std::mt19937 &rng, grid_t &grid, int size, double density) {
+    auto queries = MakeQueries(rng, grid, size, true);
+
+    wom::GridSearchWorkspace workspace;
+    std::vector<grid_t::GridPathNode<units::second>> path;
+    std::vector<size_t> thetaExpansions;
+    double thetaTotal = 0, shortcutTotal = 0;
+    int found = 0;
+    for (const Query &q : queries) {
+      grid.ThetaStarStrict<units::second>(q.start, q.end, cost, cost, workspace, path);
+      thetaExpansions.push_back(workspace.GetExpansions());
+      auto astar = grid.AStarStrict<units::second>(q.start, q.end, cost, cost);
+      if (path.empty() || astar.empty() || astar.back().cost.value() == 0) continue;
+      thetaTotal += path.back().cost.value() / astar.back().cost.value();
+      shortcutTotal += grid.Shortcut<units::second>(astar, cost, cost).back().cost.value() / astar.back().cost.value();
+      found++;
+    }
+    double thetaRatio = found > 0 ? thetaTotal / found : 0;
+    double shortcutRatio = found > 0 ? shortcutTotal / found : 0;
+
+    size_t i = 0;
+    reporter.Measure("GridThetaStarAStar", { { "size", size }, { "density", density } }, [&]() {
+      const Query &q = queries[i++ % queries.size()];
+      grid.AStarStrict<units::second>(q.start, q.end, cost, cost, workspace, path);
+      return q.expansions;
+    });
+    i = 0;
+    reporter.Measure("GridThetaStar", { { "size", size }, { "density", density }, { "mean_cost_ratio", thetaRatio } }, [&]() {
+      size_t n = i++ % queries.size();
+      grid.ThetaStarStrict<units::second>(queries[n].start, queries[n].end, cost, cost, workspace, path);
+      return thetaExpansions[n];
+    });
+    i = 0;
+    reporter.Measure("GridShortcut", { { "size", size }, { "density", density }, { "mean_cost_ratio", shortcutRatio } }, [&]() {
+      const Query &q = queries[i++ % queries.size()];
+      grid.Shortcut<units::second>(grid.AStarStrict<units::second>(q.start, q.end, cost, cost), cost, cost);
+      return q.expansions;
+    });
+  });
+}
+
+// Paths from N starts to one goal: one cost-to-goal field build and N descents against N AStarStrict
+// queries. The goals cycle through more than the field cache holds, so every op rebuilds its field.
+BENCHMARK(GridGoalField) {
+  cost_per_m_t cost{1};
+  const double density = 0.2;
+  for (int size : kSizes) {
+    std::mt19937 rng{4788};
+    grid_t grid = RandomGrid(rng, size, density);
+    std::vector<Eigen::Vector2i> goals;
+    for (int i = 0; i < 8; i++) goals.push_back(RandomCell(rng, grid, size, true));
+
+    for (int starts : { 1, 4, 16, 64 }) {
+      std::vector<Eigen::Vector2i> cells;
+      for (int i = 0; i < starts; i++) cells.push_back(RandomCell(rng, grid, size, true));
+
+      size_t i = 0;
+      reporter.Measure("GridGoalFieldAStar", { { "size", size }, { "density", density }, { "starts", starts } }, [&]() {
+        const Eigen::Vector2i &goal = goals[i++ % goals.size()];
+        for (const Eigen::Vector2i &start : cells) grid.AStarStrict<units::second>(start, goal, cost, cost);
+        return (size_t)0;
+      });
+      i = 0;
+      reporter.Measure("GridGoalField", { { "size", size }, { "density", density }, { "starts", starts } }, [&]() {
+        const Eigen::Vector2i &goal = goals[i++ % goals.size()];
+        for (const Eigen::Vector2i &start : cells) grid.GoalFieldPathStrict<units::second>(start, goal, cost, cost);
+        return (size_t)0;
+      });
+    }
+  }
+}
+
+// AStarBatchStrict on the global pool against a serial loop of AStarStrict over the same queries.
+// Each op runs the whole batch.
+BENCHMARK(GridAStarBatch) {
+  cost_per_m_t cost{1};
+  double threads = wom::ThreadPool::Global().Concurrency();
+  ForEachConfiguration([&](std::mt19937 &rng, grid_t &grid, int size, double density) {
+    auto queries = MakeQueries(rng, grid, size, true);
+    std::vector<std::pair<Eigen::Vector2i, Eigen::Vector2i>> pairs;
+    size_t expansions = 0;
+    for (const Query &q : queries) {
+      pairs.emplace_back(q.start, q.end);
+      expansions += q.expansions;
+    }
+
+    wom::GridSearchWorkspace workspace;
+    std::vector<grid_t::GridPathNode<units::second>> path;
+    reporter.Measure("GridAStarBatchSerial", { { "size", size }, { "density", density } }, [&]() {
+      for (const Query &q : queries) grid.AStarStrict<units::second>(q.start, q.end, cost, cost, workspace, path);
+      return expansions;
+    });
+    reporter.Measure("GridAStarBatch", { { "size", size }, { "density", density }, { "threads", threads } }, [&]() {
+      grid.AStarBatchStrict<units::second>(pairs, cost, cost);
+      return expansions;
+    });
+  });
+}
+
+BENCHMARK(GridGetClosestValidNode) {
+  ForEachConfiguration([&](std::mt19937 &rng, grid_t &grid, int size, double density) {
+    std::vector<Eigen::Vector2i> cells;
+    for (int i = 0; i < 256; i++) cells.push_back(RandomCell(rng, grid, size, false));
+    // Build the distance field up front, otherwise the first occupied cell queried pays for it.
+    grid.GetDistanceField();
+
+    size_t i = 0;
+    reporter.Measure("GridGetClosestValidNode", { { "size", size }, { "density", density }, { "update", 0 } }, [&]() {
+      grid.GetClosestValidNode(cells[i++ % cells.size()]);
+      return (size_t)0;
+    });
+
+    // Toggle a cell before each query, so every query pays for an incremental distance field update.
+    reporter.Measure("GridGetClosestValidNode", { { "size", size }, { "density", density }, { "update", 1 } }, [&]() {
+      const Eigen::Vector2i &cell = cells[i++ % cells.size()];
+      grid.Set(cell, !grid.Get(cell));
+      grid.GetClosestValidNode(cell);
+      return (size_t)0;
+    });
+  });
+}
+
+BENCHMARK(GridFillF) {
+  for (int size : kSizes) {
+    grid_t grid{ 0_m, size * 1_m, 0_m, size * 1_m, (size_t)size, (size_t)size };
+    units::meter_t centre = size * 0.5_m, radius = size * 0.3_m;
+    auto disc = [&](units::meter_t x, units::meter_t y) {
+      return (x - centre) * (x - centre) + (y - centre) * (y - centre) < radius * radius;
+    };
+
+    // FillF returns a copy of the grid, which would be timed along with the fill. A pool with no
+    // workers runs ParallelFillF inline on the caller, giving the same fill in place.
+    wom::ThreadPool serial{0};
+    reporter.Measure("GridFillF", { { "size", size } }, [&]() {
+      grid.ParallelFillF(disc, serial);
+      return (size_t)0;
+    });
+    reporter.Measure("GridParallelFillF", { { "size", size }, { "threads", (double)wom::ThreadPool::Global().Concurrency() } }, [&]() {
+      grid.ParallelFillF(disc);
+      return (size_t)0;
+    });
+  }
+}
@@ -0,0 +1,37 @@
+#include "Bench.h"
+#include "LUT.h"
+
+#include <random>
+
+using namespace wom;
+
+static volatile double g_sink;
+
+BENCHMARK(LUTEstimate) {
+  // Reported as mode 0 (linear scan, the original Estimate), 1 (binary search), 2 (uniform) or 3 (monotone cubic).
+  const std::pair<LUTMode, double> modes[] = {
+    { LUTMode::kLinearScan, 0 }, { LUTMode::kBinarySearch, 1 }, { LUTMode::kUniform, 2 }, { LUTMode::kMonotoneCubic, 3 }
+  };
+
+  for (int size : { 4, 8, 16, 32, 64, 256, 1024 }) {
+    // A shooter-style table: unevenly spaced distances, so the uniform mode has to resample.
+    std::mt19937 rng{4788};
+    std::uniform_real_distribution<double> gap{0.1, 0.5}, value{1000, 5000};
+    std::vector<LUTPoint<double, double>> points;
+    double x = 1;
+    for (int i = 0; i < size; i++, x += gap(rng)) points.push_back({ x, value(rng) });
+
+    std::uniform_real_distribution<double> query{0, x + 1};
+    std::vector<double> queries(1024);
+    for (auto &q : queries) q = query(rng);
+
+    for (auto [mode, id] : modes) {
+      LUT<double, double> lut(points, mode);
+      size_t i = 0;
+      reporter.Measure("LUTEstimate", { { "size", size }, { "mode", id } }, [&]() {
+        g_sink = lut.Estimate(queries[i++ % queries.size()]);
+        return (size_t)0;
+      });
+    }
+  }
+}
@@ -0,0 +1,74 @@
+#include "Bench.h"
+#include "PIDBank.h"
+#include "ScheduledPID.h"
+
+#include <units/angle.h>
+#include <units/voltage.h>
+
+#include <vector>
+
+using namespace wom;
+
+using conf_t = PIDConfig<units::radian, units::volt>;
+
+static volatile double g_sink;
+
+// Eight controllers, as in the four swerve modules, each stepped once per op.
+BENCHMARK(PIDCalculate) {
+  conf_t config{ "/bench/pid/config", conf_t::kp_t{4}, conf_t::ki_t{0.5}, conf_t::kd_t{0.1}, 0.05_rad };
+
+  // Reported as telemetry 0 (off), 1 (decimated every 10) or 2 (full).
+  for (auto [level, id] : { std::pair{ PIDTelemetry::kOff, 0.0 }, { PIDTelemetry::kDecimated, 1.0 }, { PIDTelemetry::kFull, 2.0 } }) {
+    std::vector<PIDController<units::radian, units::volt>> controllers;
+    for (int i = 0; i < 8; i++) {
+      controllers.emplace_back("/bench/pid/" + std::to_string(i), config, 1_rad);
+      controllers.back().SetTelemetry(level, 10);
+    }
+
+    double pv = 0;
+    reporter.Measure("PIDCalculate", { { "controllers", 8 }, { "telemetry", id } }, [&]() {
+      pv += 1e-3;
+      double sum = 0;
+      for (auto &pid : controllers) sum += pid.Calculate(units::radian_t{pv}, 20_ms).value();
+      g_sink = sum;
+      return (size_t)0;
+    });
+  }
+
+  PIDBank<8> bank;
+  for (size_t i = 0; i < 8; i++) {
+    auto lane = bank.GetLane<units::radian, units::volt>(i);
+    lane.Configure(config);
+    lane.SetSetpoint(1_rad);
+  }
+  double pv = 0;
+  reporter.Measure("PIDBankCalculate", { { "controllers", 8 } }, [&]() {
+    pv += 1e-3;
+    for (size_t i = 0; i < 8; i++) bank.SetInput(i, pv);
+    bank.Calculate(20_ms);
+    g_sink = bank.GetOutput(0);
+    return (size_t)0;
+  });
+
+  // Gains looked up from 16-point tables on the process variable, as an arm would.
+  std::vector<LUTPoint<units::radian_t, conf_t::kp_t>> kp;
+  std::vector<LUTPoint<units::radian_t, conf_t::ki_t>> ki;
+  std::vector<LUTPoint<units::radian_t, conf_t::kd_t>> kd;
+  for (int i = 0; i < 16; i++) {
+    units::radian_t x{ i * 0.1 };
+    kp.push_back({ x, conf_t::kp_t{4 + i * 0.1} });
+    ki.push_back({ x, conf_t::ki_t{0.5} });
+    kd.push_back({ x, conf_t::kd_t{0.1 + i * 0.01} });
+  }
+  std::vector<LUTScheduledPIDController<units::radian, units::volt>> scheduled;
+  for (int i = 0; i < 8; i++)
+    scheduled.emplace_back("/bench/pid/scheduled/" + std::to_string(i), config, LUT{ kp }, LUT{ ki }, LUT{ kd }, 1_rad, PIDTelemetry::kOff);
+  pv = 0;
+  reporter.Measure("PIDScheduledCalculate", { { "controllers", 8 }, { "points", 16 } }, [&]() {
+    pv = pv > 1.5 ? 0 : pv + 1e-3;
+    double sum = 0;
+    for (auto &pid : scheduled) sum += pid.Calculate(units::radian_t{pv}, 20_ms).value();
+    g_sink = sum;
+    return (size_t)0;
+  });
+}
@@ -0,0 +1,37 @@
+#include "Bench.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// Usage: WombatBench [--filter <substring>] [--min-time <seconds>] [--out <file>]
+// Results are written as one JSON object per line, to stdout unless --out is given.
+int main(int argc, char **argv) {
+  bench::Options options;
+  std::ofstream file;
+  for (int i = 1; i < argc; i++) {
+    bool hasValue = i + 1 < argc;
+    if (!std::strcmp(argv[i], "--filter") && hasValue) {
+      options.filter = argv[++i];
+    } else if (!std::strcmp(argv[i], "--min-time") && hasValue) {
+      options.minTime = std::atof(argv[++i]);
+    } else if (!std::strcmp(argv[i], "--out") && hasValue) {
+      file.open(argv[++i]);
+      if (!file) {
+        std::cerr << "Could not open " << argv[i] << std::endl;
+        return 1;
+      }
+    } else {
+      std::cerr << "Usage: " << argv[0] << " [--filter <substring>] [--min-time <seconds>] [--out <file>]" << std::endl;
+      return 1;
+    }
+  }
+
+  bench::Reporter reporter{ file.is_open() ? file : std::cout, options };
+  for (auto &benchmark : bench::Registry()) {
+    if (benchmark.name.find(options.filter) == std::string::npos) continue;
+    std::cerr << "Running " << benchmark.name << std::endl;
+    benchmark.fn(reporter);
+  }
+  return 0;
+}
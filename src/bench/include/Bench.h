@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * A small harness for the WombatBench target. Benchmarks register themselves with BENCHMARK and
+ * report one Result per configuration, which is written as a line of JSON so runs from different
+ * commits can be diffed or loaded into a script.
+ *
+ * Heap use is measured by replacing the global operator new in Bench.cpp, so every allocation made
+ * while an operation runs (including inside the library) is counted.
+ */
+namespace bench {
+  struct AllocationStats {
+    size_t count;      // Number of allocations.
+    size_t bytes;      // Total bytes allocated.
+    size_t live;       // Bytes currently allocated.
+    size_t peak;       // Most bytes live at once since the last ResetPeak.
+  };
+
+  AllocationStats GetAllocationStats();
+  // Start tracking the peak from the current live bytes.
+  void ResetPeak();
+
+  struct Result {
+    std::string name;
+    std::vector<std::pair<std::string, double>> params;
+    size_t ops = 0;
+    double nsPerOp = 0;
+    double expansionsPerOp = 0;    // 0 for operations that do not search.
+    double allocationsPerOp = 0;
+    double bytesPerOp = 0;
+    size_t peakBytes = 0;          // Peak heap growth over the live bytes before the first op.
+  };
+
+  struct Options {
+    double minTime = 0.2;          // Seconds to repeat each configuration for.
+    std::string filter;            // Only run benchmarks whose name contains this.
+  };
+
+  class Reporter {
+   public:
+    Reporter(std::ostream &out, Options options) : _out(out), _options(std::move(options)) {}
+
+    const Options &GetOptions() const { return _options; }
+
+    void Report(const Result &result);
+
+    /**
+     * Time op, which returns the number of nodes it expanded (or 0), over at least the configured
+     * minimum time after one untimed warm-up call, and report the per-op averages.
+     */
+    template<typename F>
+    Result Measure(std::string name, std::vector<std::pair<std::string, double>> params, F &&op) {
+      using clock = std::chrono::steady_clock;
+      op();
+
+      Result result{ std::move(name), std::move(params) };
+      size_t expansions = 0;
+      ResetPeak();
+      AllocationStats before = GetAllocationStats();
+      // Ops run in doubling batches between clock reads, so the clock does not dominate short ops.
+      auto start = clock::now(), now = start;
+      size_t batch = 1;
+      do {
+        for (size_t i = 0; i < batch; i++) expansions += op();
+        result.ops += batch;
+        batch = std::min(batch * 2, kMaxBatch);
+        now = clock::now();
+      } while (std::chrono::duration<double>(now - start).count() < _options.minTime);
+      AllocationStats after = GetAllocationStats();
+
+      double ops = (double)result.ops;
+      result.nsPerOp = std::chrono::duration<double, std::nano>(now - start).count() / ops;
+      result.expansionsPerOp = expansions / ops;
+      result.allocationsPerOp = (after.count - before.count) / ops;
+      result.bytesPerOp = (after.bytes - before.bytes) / ops;
+      result.peakBytes = after.peak - before.live;
+      Report(result);
+      return result;
+    }
+
+   private:
+    static constexpr size_t kMaxBatch = 1 << 16;
+
+    std::ostream &_out;
+    Options _options;
+  };
+
+  using BenchmarkFn = std::function<void(Reporter &)>;
+
+  struct Benchmark {
+    std::string name;
+    BenchmarkFn fn;
+  };
+
+  std::vector<Benchmark> &Registry();
+  int Register(std::string name, BenchmarkFn fn);
+}
+
+#define BENCHMARK(name)                                                                     \
+  static void bench_##name(bench::Reporter &);                                              \
+  static int bench_##name##_registered = bench::Register(#name, bench_##name);              \
+  static void bench_##name(bench::Reporter &reporter)
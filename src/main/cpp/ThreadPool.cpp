@@ -0,0 +1,135 @@
+#include "ThreadPool.h"
+
+using namespace wom;
+
+namespace {
+  // Set on pool workers, and on callers while they help with a ParallelFor.
+  thread_local bool _in_pool = false;
+
+  uint64_t Pack(uint64_t begin, uint64_t end) { return (begin << 32) | end; }
+  uint64_t Begin(uint64_t range) { return range >> 32; }
+  uint64_t End(uint64_t range) { return range & 0xFFFFFFFF; }
+}
+
+ThreadPool::ThreadPool(unsigned int threads) : _slots(new Slot[threads + 1]) {
+  for (unsigned int i = 0; i < threads; i++)
+    _threads.emplace_back([this, i]() { Worker(i); });
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lk(_mutex);
+    _stop = true;
+  }
+  _wake.notify_all();
+  for (auto &t : _threads) t.join();
+}
+
+ThreadPool &ThreadPool::Global() {
+  static ThreadPool pool;
+  return pool;
+}
+
+unsigned int ThreadPool::DefaultThreads() {
+  unsigned int hw = std::thread::hardware_concurrency();
+  return hw > 1 ? hw - 1 : 0;
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)> &fn) {
+  ParallelFor(count, [&fn](size_t i, size_t) { fn(i); });
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t, size_t)> &fn) {
+  if (count == 0) return;
+  if (_in_pool || _threads.empty() || count == 1) {
+    for (size_t i = 0; i < count; i++) fn(i, 0);
+    return;
+  }
+
+  std::lock_guard<std::mutex> dispatch(_dispatchMutex);
+  size_t participants = Concurrency();
+  for (size_t w = 0; w < participants; w++)
+    _slots[w].range = Pack(count * w / participants, count * (w + 1) / participants);
+
+  {
+    std::lock_guard<std::mutex> lk(_mutex);
+    _job = &fn;
+    _busy = _threads.size();
+    _generation++;
+  }
+  _wake.notify_all();
+
+  // The caller takes the last slot.
+  _in_pool = true;
+  Run(_threads.size());
+  _in_pool = false;
+
+  std::unique_lock<std::mutex> lk(_mutex);
+  _done.wait(lk, [this]() { return _busy == 0; });
+  _job = nullptr;
+}
+
+void ThreadPool::Worker(size_t worker) {
+  _in_pool = true;
+  uint64_t seen = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lk(_mutex);
+      _wake.wait(lk, [&]() { return _stop || _generation != seen; });
+      if (_stop) return;
+      seen = _generation;
+    }
+
+    Run(worker);
+
+    std::lock_guard<std::mutex> lk(_mutex);
+    if (--_busy == 0) _done.notify_one();
+  }
+}
+
+void ThreadPool::Run(size_t worker) {
+  size_t index;
+  while (Take(worker, index) || Steal(worker, index))
+    (*_job)(index, worker);
+}
+
+// Take the next index from the front of our own share.
+bool ThreadPool::Take(size_t worker, size_t &index) {
+  std::atomic<uint64_t> &slot = _slots[worker].range;
+  uint64_t range = slot.load();
+  while (Begin(range) < End(range)) {
+    if (slot.compare_exchange_weak(range, Pack(Begin(range) + 1, End(range)))) {
+      index = Begin(range);
+      return true;
+    }
+  }
+  return false;
+}
+
+// Take the back half of the largest remaining share, running its first index and keeping the rest.
+bool ThreadPool::Steal(size_t worker, size_t &index) {
+  size_t participants = Concurrency();
+  while (true) {
+    size_t victim = participants, most = 0;
+    for (size_t w = 0; w < participants; w++) {
+      uint64_t range = _slots[w].range.load();
+      if (w != worker && End(range) > Begin(range) && End(range) - Begin(range) > most) {
+        most = End(range) - Begin(range);
+        victim = w;
+      }
+    }
+    if (victim == participants) return false;
+
+    std::atomic<uint64_t> &slot = _slots[victim].range;
+    uint64_t range = slot.load();
+    uint64_t begin = Begin(range), end = End(range);
+    if (begin >= end) continue;
+
+    uint64_t mid = begin + (end - begin) / 2;
+    if (slot.compare_exchange_strong(range, Pack(begin, mid))) {
+      index = mid;
+      _slots[worker].range = Pack(mid + 1, end);
+      return true;
+    }
+  }
+}
@@ -4,6 +4,8 @@
 #include <networktables/NetworkTableInstance.h>
 #include <units/math.h>
 
+#include <algorithm>
+
 using namespace wom;
 
 void SwerveModuleConfig::WriteNT(std::shared_ptr<nt::NetworkTable> table) const {
@@ -14,8 +16,8 @@ void SwerveModuleConfig::WriteNT(std::shared_ptr<nt::NetworkTable> table) const
 
 SwerveModule::SwerveModule(std::string path, SwerveModuleConfig config, SwerveModule::angle_pid_conf_t anglePID, SwerveModule::velocity_pid_conf_t velocityPID) 
   : _config(config),
-    _anglePIDController(path + "/pid/angle", anglePID),
-    _velocityPIDController(path + "/pid/velocity", velocityPID),
+    _anglePIDController(path + "/pid/angle", anglePID, 0_rad, PIDTelemetry::kDecimated),
+    _velocityPIDController(path + "/pid/velocity", velocityPID, 0_mps, PIDTelemetry::kDecimated),
     _table(nt::NetworkTableInstance::GetDefault().GetTable(path))
 {
   _anglePIDController.SetWrap(360_deg);
@@ -31,18 +33,18 @@ void SwerveModule::OnUpdate(units::second_t dt) {
   units::volt_t driveVoltage{0};
   units::volt_t turnVoltage{0};
 
-  switch(_state) {
-    case SwerveModuleState::kIdle:
-      driveVoltage = 0_V;
-      turnVoltage = 0_V;
-      break;
-    case SwerveModuleState::kPID:
-      {
-        auto feedforward = _config.driveMotor.motor.Voltage(0_Nm, units::radians_per_second_t{(_velocityPIDController.GetSetpoint() / _config.wheelRadius).value()});
-        driveVoltage = _velocityPIDController.Calculate(GetSpeed(), dt, feedforward);
-        turnVoltage = _anglePIDController.Calculate(_config.turnMotor.encoder->GetEncoderPosition(), dt);
-      }
-      break;
+  if (_state == SwerveModuleState::kPID) {
+    driveVoltage = _velocityPIDController.Calculate(GetSpeed(), dt, GetDriveFeedforward());
+    turnVoltage = _anglePIDController.Calculate(GetTurnAngle(), dt);
+  }
+
+  OnUpdate(dt, driveVoltage, turnVoltage);
+}
+
+void SwerveModule::OnUpdate(units::second_t dt, units::volt_t driveVoltage, units::volt_t turnVoltage) {
+  if (_state != SwerveModuleState::kPID) {
+    driveVoltage = 0_V;
+    turnVoltage = 0_V;
   }
 
   units::newton_meter_t torqueLimit = 50_kg/4 * _config.wheelRadius * _currentAccelerationLimit;
@@ -65,7 +67,7 @@ void SwerveModule::OnUpdate(units::second_t dt) {
   _config.turnMotor.transmission->SetVoltage(turnVoltage);
 
   _table->GetEntry("speed").SetDouble(GetSpeed().value());
-  _table->GetEntry("angle").SetDouble(_config.turnMotor.encoder->GetEncoderPosition().convert<units::degree>().value());
+  _table->GetEntry("angle").SetDouble(GetTurnAngle().convert<units::degree>().value());
   _config.WriteNT(_table->GetSubTable("config"));
 }
 
@@ -121,6 +123,26 @@ void SwerveModule::ModuleVectorHandler(frc::ChassisSpeeds speeds){
   _velocityPIDController.SetSetpoint(velocity);
 }
 
+bool SwerveModule::IsPIDActive() const {
+  return _state == SwerveModuleState::kPID;
+}
+
+units::volt_t SwerveModule::GetDriveFeedforward() const {
+  return _config.driveMotor.motor.Voltage(0_Nm, units::radians_per_second_t{(_velocityPIDController.GetSetpoint() / _config.wheelRadius).value()});
+}
+
+units::radian_t SwerveModule::GetTurnAngle() const {
+  return _config.turnMotor.encoder->GetEncoderPosition();
+}
+
+PIDController<units::radians, units::volt> &SwerveModule::GetAnglePIDController() {
+  return _anglePIDController;
+}
+
+PIDController<units::meters_per_second, units::volt> &SwerveModule::GetVelocityPIDController() {
+  return _velocityPIDController;
+}
+
 units::meters_per_second_t SwerveModule::GetSpeed() const {
   return units::meters_per_second_t{_config.driveMotor.encoder->GetEncoderAngularVelocity().value() * _config.wheelRadius.value()};
 }
@@ -158,9 +180,9 @@ SwerveDrive::SwerveDrive(SwerveDriveConfig config, frc::Pose2d initialPose) :
     initialPose,
     _config.stateStdDevs, _config.visionMeasurementStdDevs
   ),
-  _anglePIDController(config.path + "/pid/heading", _config.poseAnglePID),
-  _xPIDController(config.path + "/pid/x", _config.posePositionPID),
-  _yPIDController(config.path + "/pid/y", _config.posePositionPID),
+  _anglePIDController(config.path + "/pid/heading", _config.poseAnglePID, 0_rad, PIDTelemetry::kDecimated),
+  _xPIDController(config.path + "/pid/x", _config.posePositionPID, 0_m, PIDTelemetry::kDecimated),
+  _yPIDController(config.path + "/pid/y", _config.posePositionPID, 0_m, PIDTelemetry::kDecimated),
   _table(nt::NetworkTableInstance::GetDefault().GetTable(_config.path))
 {
 
@@ -243,8 +265,12 @@ void SwerveDrive::OnUpdate(units::second_t dt) {
       break;
   }
 
-  for (auto mod = _modules.begin(); mod < _modules.end(); mod++) {
-    mod->OnUpdate(dt);
+  if (_usePIDBank) {
+    UpdateModulesBanked(dt);
+  } else {
+    for (auto mod = _modules.begin(); mod < _modules.end(); mod++) {
+      mod->OnUpdate(dt);
+    }
   }
 
   _poseEstimator.Update(
@@ -261,6 +287,42 @@ void SwerveDrive::OnUpdate(units::second_t dt) {
   _config.WriteNT(_table->GetSubTable("config"));
 }
 
+void SwerveDrive::UsePIDBank(bool enable) {
+  _usePIDBank = enable;
+}
+
+void SwerveDrive::UpdateModulesBanked(units::second_t dt) {
+  // Lane 2i is module i's angle loop and lane 2i + 1 its velocity loop. The modules' own
+  // controllers still hold the setpoints and gains (so NT tuning applies), the bank does the math.
+  // The bank has lanes for kModuleCount modules.
+  const size_t count = std::min(_modules.size(), kModuleCount);
+  for (size_t i = 0; i < count; i++) {
+    SwerveModule &mod = _modules[i];
+    auto angle = _moduleBank.GetLane<units::radian, units::volt>(2 * i);
+    auto velocity = _moduleBank.GetLane<units::meters_per_second, units::volt>(2 * i + 1);
+
+    angle.Configure(mod.GetAnglePIDController().config);
+    angle.SetWrap(360_deg);
+    velocity.Configure(mod.GetVelocityPIDController().config);
+
+    angle.SetSetpoint(mod.GetAnglePIDController().GetSetpoint());
+    velocity.SetSetpoint(mod.GetVelocityPIDController().GetSetpoint());
+
+    angle.SetEnabled(mod.IsPIDActive());
+    velocity.SetEnabled(mod.IsPIDActive());
+    angle.SetInput(mod.GetTurnAngle());
+    velocity.SetInput(mod.GetSpeed(), mod.GetDriveFeedforward());
+  }
+
+  _moduleBank.Calculate(dt);
+
+  for (size_t i = 0; i < count; i++) {
+    _modules[i].OnUpdate(dt,
+      _moduleBank.GetLane<units::meters_per_second, units::volt>(2 * i + 1).GetOutput(),
+      _moduleBank.GetLane<units::radian, units::volt>(2 * i).GetOutput());
+  }
+}
+
 void SwerveDrive::SetXWheelState(){
   _state = SwerveDriveState::kXWheels;
 }
@@ -284,6 +346,7 @@ void SwerveDrive::OnStart() {
   _xPIDController.Reset();
   _yPIDController.Reset();
   _anglePIDController.Reset();
+  _moduleBank.Reset();
 
   _modules[0].OnStart(); // front left
   _modules[1].OnStart(); // front right
@@ -0,0 +1,58 @@
+#include "grid/GridFile.h"
+
+#if defined(_WIN32)
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace wom;
+
+std::shared_ptr<const MappedFile> MappedFile::Open(const std::string &path) {
+  std::shared_ptr<MappedFile> file{ new MappedFile() };
+
+#if defined(_WIN32)
+  std::ifstream in(path, std::ios::binary | std::ios::ate);
+  if (!in)
+    throw std::runtime_error("Could not open file: " + path);
+  file->_size = (size_t)in.tellg();
+  file->_buffer.reset(new uint8_t[file->_size]);
+  in.seekg(0);
+  in.read((char *)file->_buffer.get(), file->_size);
+  file->_data = file->_buffer.get();
+#else
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error("Could not open file: " + path);
+
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    throw std::runtime_error("Could not stat file: " + path);
+  }
+  file->_size = (size_t)st.st_size;
+
+  if (file->_size > 0) {
+    void *data = ::mmap(nullptr, file->_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      ::close(fd);
+      throw std::runtime_error("Could not map file: " + path);
+    }
+    file->_data = (const uint8_t *)data;
+    file->_mapped = true;
+  }
+  // The mapping stays valid after the descriptor is closed.
+  ::close(fd);
+#endif
+
+  return file;
+}
+
+MappedFile::~MappedFile() {
+#if !defined(_WIN32)
+  if (_mapped) ::munmap((void *)_data, _size);
+#endif
+}
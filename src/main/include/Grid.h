@@ -4,10 +4,24 @@
 
 #include <units/base.h>
 #include <units/math.h>
+
+#include "grid/DistanceField.h"
+#include "grid/TraversalCostLayer.h"
+#include "ThreadPool.h"
+
+#include <deque>
+#include <span>
+#include <functional>
 #include <queue>
+#include <stdexcept>
 #include <vector>
+#include <array>
+#include <cstdint>
+#include <limits>
 #include <memory>
+#include <mutex>
 #include <algorithm>
+#include <cmath>
 #include <unordered_set>
 
 namespace wom {
@@ -25,22 +39,400 @@ namespace wom {
       }
     };
 
+    // A mutex for caches kept inside a copyable object: copies get a fresh, unlocked mutex.
+    struct CacheMutex : std::mutex {
+      CacheMutex() = default;
+      CacheMutex(const CacheMutex &) : std::mutex() {}
+      CacheMutex &operator=(const CacheMutex &) { return *this; }
+    };
+
     template<typename I, typename O>
     O remap(I x, I in_min, I in_max, O out_min, O out_max) {
       return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
     }
+
+    /**
+     * Binary min-heap over dense integer ids (e.g. flattened grid cells), supporting
+     * decrease-key through a position index. All operations are O(log n), Contains is O(1).
+     */
+    template<typename Key, typename Compare = std::less<Key>>
+    class IndexedHeap {
+     public:
+      static constexpr int npos = -1;
+
+      void Resize(size_t n) {
+        _heap.clear();
+        _pos.assign(n, npos);
+      }
+
+      bool Empty() const { return _heap.empty(); }
+      size_t Size() const { return _heap.size(); }
+      bool Contains(int id) const { return _pos[id] != npos; }
+
+      int Top() const { return _heap.front().id; }
+      const Key &TopKey() const { return _heap.front().key; }
+      const Key &KeyOf(int id) const { return _heap[_pos[id]].key; }
+
+      // Insert the id, or move it to its new key if it is already in the heap.
+      void Push(int id, Key key) {
+        if (Contains(id)) {
+          Update(id, key);
+        } else {
+          _pos[id] = (int)_heap.size();
+          _heap.push_back(Entry{ key, id });
+          SiftUp(_pos[id]);
+        }
+      }
+
+      void Update(int id, Key key) {
+        int i = _pos[id];
+        bool decreased = _cmp(key, _heap[i].key);
+        _heap[i].key = key;
+        if (decreased) SiftUp(i);
+        else SiftDown(i);
+      }
+
+      int Pop() {
+        int id = _heap.front().id;
+        RemoveAt(0);
+        return id;
+      }
+
+      void Remove(int id) {
+        if (Contains(id)) RemoveAt(_pos[id]);
+      }
+
+      // Empties the heap in O(size) rather than O(capacity).
+      void Clear() {
+        for (auto &e : _heap) _pos[e.id] = npos;
+        _heap.clear();
+      }
+
+     private:
+      struct Entry {
+        Key key;
+        int id;
+      };
+
+      void RemoveAt(int i) {
+        _pos[_heap[i].id] = npos;
+        Entry last = _heap.back();
+        _heap.pop_back();
+        if (i < (int)_heap.size()) {
+          _heap[i] = last;
+          _pos[last.id] = i;
+          if (i > 0 && _cmp(last.key, _heap[(i - 1) / 2].key)) SiftUp(i);
+          else SiftDown(i);
+        }
+      }
+
+      void SiftUp(int i) {
+        Entry e = _heap[i];
+        while (i > 0) {
+          int parent = (i - 1) / 2;
+          if (!_cmp(e.key, _heap[parent].key)) break;
+          _heap[i] = _heap[parent];
+          _pos[_heap[i].id] = i;
+          i = parent;
+        }
+        _heap[i] = e;
+        _pos[e.id] = i;
+      }
+
+      void SiftDown(int i) {
+        Entry e = _heap[i];
+        int n = (int)_heap.size();
+        while (true) {
+          int child = 2 * i + 1;
+          if (child >= n) break;
+          if (child + 1 < n && _cmp(_heap[child + 1].key, _heap[child].key)) child++;
+          if (!_cmp(_heap[child].key, e.key)) break;
+          _heap[i] = _heap[child];
+          _pos[_heap[i].id] = i;
+          i = child;
+        }
+        _heap[i] = e;
+        _pos[e.id] = i;
+      }
+
+      std::vector<Entry> _heap;
+      std::vector<int> _pos;
+      Compare _cmp;
+    };
   }
 
 
-  template<typename CostT>
-  struct AStarNode {
-    Eigen::Vector2i position;
-    std::shared_ptr<AStarNode> parent;
-    units::unit_t<CostT> gScore;
-    units::unit_t<CostT> fScore;
+  /**
+   * Reusable scratch state for grid searches. The node array is sized to the grid on first use
+   * and each entry is stamped with the generation of the search that last touched it, so starting
+   * a new search is O(1) and repeated searches on the same grid do not allocate.
+   *
+   * A workspace may be shared between grids and cost types, but not between threads.
+   */
+  class GridSearchWorkspace {
+   public:
+    struct Node {
+      double gScore;
+      int parent;
+      uint32_t generation;
+      bool closed;
+    };
+
+    // Open set is ordered on fScore, ties broken towards the node closest to the goal.
+    using key_t = std::pair<double, double>;
+
+    GridSearchWorkspace() = default;
+    GridSearchWorkspace(size_t cells) { Begin(cells); }
+
+    /**
+     * Start a new search over a grid with the given number of cells.
+     */
+    void Begin(size_t cells) {
+      if (_nodes.size() != cells) {
+        _nodes.assign(cells, Node{ 0, -1, 0, false });
+        openSet.Resize(cells);
+        _generation = 0;
+      } else {
+        openSet.Clear();
+      }
+
+      if (++_generation == 0) {
+        // Generation counter wrapped, invalidate every stamp explicitly.
+        for (auto &n : _nodes) n.generation = 0;
+        _generation = 1;
+      }
+      _expansions = 0;
+    }
+
+    Node &At(int idx) {
+      Node &n = _nodes[idx];
+      if (n.generation != _generation)
+        n = Node{ std::numeric_limits<double>::infinity(), -1, _generation, false };
+      return n;
+    }
+
+    void Expanded() { _expansions++; }
+
+    /**
+     * Get the number of nodes expanded by the last search.
+     */
+    size_t GetExpansions() const { return _expansions; }
+
+    detail::IndexedHeap<key_t> openSet;
+
+   private:
+    std::vector<Node> _nodes;
+    uint32_t _generation = 0;
+    size_t _expansions = 0;
   };
 
-  template<typename T_X, typename T_Y>
+  /**
+   * Occupancy storage backed by an Eigen::MatrixXi, using one int per cell.
+   */
+  class MatrixOccupancy {
+   public:
+    MatrixOccupancy() = default;
+    MatrixOccupancy(size_t rows, size_t cols) : _matrix(Eigen::MatrixXi::Zero(rows, cols)) {}
+    MatrixOccupancy(const Eigen::MatrixXi &matrix) : _matrix(matrix) {}
+
+    Eigen::Index rows() const { return _matrix.rows(); }
+    Eigen::Index cols() const { return _matrix.cols(); }
+
+    bool Get(int y, int x) const { return _matrix(y, x) != 0; }
+    void Set(int y, int x, bool occupied) { _matrix(y, x) = occupied; }
+
+    void Fill(bool value) { _matrix.fill(value ? 1 : 0); }
+    void Load(const Eigen::MatrixXi &matrix) { _matrix = matrix; }
+
+    // Always owned, see BitPackedOccupancy::MakeOwned.
+    void MakeOwned() {}
+
+    // Set columns [x0, x1] of row y. Indices must be in bounds.
+    void FillRow(int y, int x0, int x1, bool occupied) {
+      _matrix.row(y).segment(x0, x1 - x0 + 1).setConstant(occupied ? 1 : 0);
+    }
+
+    // Whether any cell in columns [x0, x1] of row y is occupied. Indices must be in bounds.
+    bool AnyInRow(int y, int x0, int x1) const {
+      for (int x = x0; x <= x1; x++)
+        if (_matrix(y, x)) return true;
+      return false;
+    }
+
+    // Whether any cell in the inclusive box [x0, x1] x [y0, y1] is occupied. Indices must be in bounds.
+    bool AnyInBox(int x0, int y0, int x1, int y1) const {
+      return (_matrix.block(y0, x0, y1 - y0 + 1, x1 - x0 + 1).array() != 0).any();
+    }
+
+    Eigen::MatrixXi ToMatrix() const { return _matrix; }
+
+   private:
+    Eigen::MatrixXi _matrix;
+  };
+
+  /**
+   * Occupancy storage packing 64 cells into each word, row-major. Each row starts on a fresh
+   * word, so row and box queries test whole words at once and rows can be written independently
+   * (including from different threads).
+   * A 5cm full-field grid (~330 x 160 cells) is under 8KB.
+   *
+   * The words may also be a read-only view of memory owned elsewhere (e.g. a memory-mapped grid
+   * file, see grid/GridFile.h). The first write to a view copies the words, so writes from several
+   * threads must be preceded by MakeOwned on one.
+   */
+  class BitPackedOccupancy {
+   public:
+    using word_t = uint64_t;
+    static constexpr int kBitsPerWord = 64;
+
+    BitPackedOccupancy() = default;
+    BitPackedOccupancy(size_t rows, size_t cols)
+      : _rows((Eigen::Index)rows), _cols((Eigen::Index)cols), _wordsPerRow((cols + kBitsPerWord - 1) / kBitsPerWord),
+        _words(rows * _wordsPerRow, 0) {}
+    BitPackedOccupancy(const Eigen::MatrixXi &matrix) : BitPackedOccupancy(matrix.rows(), matrix.cols()) {
+      Load(matrix);
+    }
+
+    /**
+     * View rows * WordsPerRow() words laid out as this storage would hold them, without copying.
+     * owner keeps the memory alive for as long as the view (or any copy of it) exists.
+     */
+    static BitPackedOccupancy View(size_t rows, size_t cols, const word_t *words, std::shared_ptr<const void> owner) {
+      BitPackedOccupancy storage;
+      storage._rows = (Eigen::Index)rows;
+      storage._cols = (Eigen::Index)cols;
+      storage._wordsPerRow = (cols + kBitsPerWord - 1) / kBitsPerWord;
+      storage._view = words;
+      storage._viewOwner = std::move(owner);
+      return storage;
+    }
+
+    Eigen::Index rows() const { return _rows; }
+    Eigen::Index cols() const { return _cols; }
+    size_t WordsPerRow() const { return _wordsPerRow; }
+    bool IsView() const { return _view != nullptr; }
+
+    // Copy a view into words of our own, so that later writes don't have to.
+    void MakeOwned() { Own(); }
+
+    const word_t *Row(int y) const { return Words() + y * _wordsPerRow; }
+    word_t *Row(int y) {
+      Own();
+      return _words.data() + y * _wordsPerRow;
+    }
+
+    bool Get(int y, int x) const {
+      return (Row(y)[x / kBitsPerWord] >> (x % kBitsPerWord)) & 1;
+    }
+
+    void Set(int y, int x, bool occupied) {
+      word_t bit = word_t{1} << (x % kBitsPerWord);
+      word_t &w = Row(y)[x / kBitsPerWord];
+      w = occupied ? (w | bit) : (w & ~bit);
+    }
+
+    void Fill(bool value) {
+      Discard();
+      std::fill(_words.begin(), _words.end(), value ? ~word_t{0} : word_t{0});
+      if (value) ClearPadding();
+    }
+
+    void Load(const Eigen::MatrixXi &matrix) {
+      Discard();
+      std::fill(_words.begin(), _words.end(), word_t{0});
+      for (int y = 0; y < _rows; y++)
+        for (int x = 0; x < _cols; x++)
+          if (matrix(y, x)) Set(y, x, true);
+    }
+
+    // Set columns [x0, x1] of row y, a word at a time. Indices must be in bounds.
+    void FillRow(int y, int x0, int x1, bool occupied) {
+      word_t *row = Row(y);
+      int w0 = x0 / kBitsPerWord, w1 = x1 / kBitsPerWord;
+      for (int w = w0; w <= w1; w++) {
+        word_t mask = ~word_t{0};
+        if (w == w0) mask &= ~word_t{0} << (x0 % kBitsPerWord);
+        if (w == w1) mask &= ~word_t{0} >> (kBitsPerWord - 1 - x1 % kBitsPerWord);
+        row[w] = occupied ? (row[w] | mask) : (row[w] & ~mask);
+      }
+    }
+
+    // Whether any cell in columns [x0, x1] of row y is occupied. Indices must be in bounds.
+    bool AnyInRow(int y, int x0, int x1) const {
+      const word_t *row = Row(y);
+      int w0 = x0 / kBitsPerWord, w1 = x1 / kBitsPerWord;
+      word_t first = ~word_t{0} << (x0 % kBitsPerWord);
+      word_t last = ~word_t{0} >> (kBitsPerWord - 1 - x1 % kBitsPerWord);
+      if (w0 == w1)
+        return (row[w0] & first & last) != 0;
+      if (row[w0] & first) return true;
+      for (int w = w0 + 1; w < w1; w++)
+        if (row[w]) return true;
+      return (row[w1] & last) != 0;
+    }
+
+    // Whether any cell in the inclusive box [x0, x1] x [y0, y1] is occupied. Indices must be in bounds.
+    bool AnyInBox(int x0, int y0, int x1, int y1) const {
+      for (int y = y0; y <= y1; y++)
+        if (AnyInRow(y, x0, x1)) return true;
+      return false;
+    }
+
+    Eigen::MatrixXi ToMatrix() const {
+      Eigen::MatrixXi m(_rows, _cols);
+      for (int y = 0; y < _rows; y++)
+        for (int x = 0; x < _cols; x++)
+          m(y, x) = Get(y, x);
+      return m;
+    }
+
+   private:
+    const word_t *Words() const { return _view ? _view : _words.data(); }
+
+    // Copy a view into our own words before writing.
+    void Own() {
+      if (!_view) return;
+      _words.assign(_view, _view + _rows * _wordsPerRow);
+      _view = nullptr;
+      _viewOwner.reset();
+    }
+
+    // Drop a view that is about to be overwritten entirely.
+    void Discard() {
+      if (!_view) return;
+      _words.assign(_rows * _wordsPerRow, 0);
+      _view = nullptr;
+      _viewOwner.reset();
+    }
+
+    // Bits past the last column are kept clear so that whole-row tests stay exact.
+    void ClearPadding() {
+      int used = (int)(_cols % kBitsPerWord);
+      if (used == 0) return;
+      word_t mask = (word_t{1} << used) - 1;
+      for (int y = 0; y < _rows; y++)
+        Row(y)[_wordsPerRow - 1] &= mask;
+    }
+
+    Eigen::Index _rows = 0, _cols = 0;
+    size_t _wordsPerRow = 0;
+    std::vector<word_t> _words;
+    const word_t *_view = nullptr;
+    std::shared_ptr<const void> _viewOwner;
+  };
+
+  /**
+   * A grid of occupied / free cells spanning [xmin, xmax] x [ymin, ymax]. Storage selects how
+   * occupancy is held: MatrixOccupancy (default) or BitPackedOccupancy. TraversalT is the integer
+   * type of the optional traversal cost layer: uint8_t (default) or uint16_t.
+   *
+   * Queries (searches, GetClosestValidNode, clearance, cost-to-goal) may run on several threads
+   * at once, including through planners bound to the grid (each planner on one thread at a time),
+   * as long as nothing changes the grid (Set, the fills, traversal costs, ...) meanwhile. The
+   * caches that queries refresh lazily (the distance field, cost-to-goal fields and AStarBatch's
+   * workspaces) are each guarded by a mutex.
+   */
+  template<typename T_X, typename T_Y, typename Storage = MatrixOccupancy, typename TraversalT = uint8_t>
   class DiscretisedOccupancyGrid {
    public:
     using X_t = units::unit_t<T_X>;
@@ -58,53 +450,197 @@ namespace wom {
       units::unit_t<CostT> cost;
     };
 
+    using storage_t = Storage;
+
     DiscretisedOccupancyGrid(X_t xmin, X_t xmax, Y_t ymin, Y_t ymax, size_t ux, size_t uy)
-      : _xmin(xmin), _xmax(xmax), _ymin(ymin), _ymax(ymax)
-    {
-      _grid.resize(uy, ux);
-      Reset();
-    }
+      : _xmin(xmin), _xmax(xmax), _ymin(ymin), _ymax(ymax), _grid(uy, ux) { }
 
     DiscretisedOccupancyGrid(X_t xmin, X_t xmax, Y_t ymin, Y_t ymax, Eigen::MatrixXi matrix)
       : _xmin(xmin), _xmax(xmax), _ymin(ymin), _ymax(ymax), _grid(matrix) { }
 
+    DiscretisedOccupancyGrid(X_t xmin, X_t xmax, Y_t ymin, Y_t ymax, Storage storage)
+      : _xmin(xmin), _xmax(xmax), _ymin(ymin), _ymax(ymax), _grid(std::move(storage)) { }
+
     void Reset() {
-      _grid.fill(0);
+      _grid.Fill(false);
+      MarkAllChanged();
     }
 
     void Fill(bool value) {
-      _grid.fill(value ? 1 : 0);
+      _grid.Fill(value);
+      MarkAllChanged();
     }
 
-    DiscretisedOccupancyGrid FillF(std::function<bool(X_t, Y_t)> f) {
-      for (int x = 0; x < _grid.cols(); x++) {
-        for (int y = 0; y < _grid.rows(); y++) {
-          ContinuousIdxT ci = CenterOf(Eigen::Vector2i{x, y});
-          _grid(y, x) = f(ci.x, ci.y);
-        }
-      }
+    // Set each cell to f(x, y) at its centre. f may be any callable taking (X_t, Y_t).
+    template<typename F>
+    DiscretisedOccupancyGrid FillF(F &&f) {
+      std::vector<X_t> xs = ColumnCentres();
+      std::vector<Y_t> ys = RowCentres();
+      for (int y = 0; y < _grid.rows(); y++)
+        for (int x = 0; x < _grid.cols(); x++)
+          _grid.Set(y, x, f(xs[x], ys[y]));
+      MarkAllChanged();
       return *this;
     }
 
+    /**
+     * As FillF, but with the rows split across a thread pool. f is called concurrently, so it must
+     * be safe to call from several threads.
+     */
+    template<typename F>
+    void ParallelFillF(F &&f, ThreadPool &pool = ThreadPool::Global()) {
+      std::vector<X_t> xs = ColumnCentres();
+      std::vector<Y_t> ys = RowCentres();
+      // Rows are written from several threads, so a view must be copied before rather than by them.
+      _grid.MakeOwned();
+      pool.ParallelFor((size_t)_grid.rows(), [&](size_t row) {
+        int y = (int)row;
+        for (int x = 0; x < _grid.cols(); x++)
+          _grid.Set(y, x, f(xs[x], ys[y]));
+      });
+      MarkAllChanged();
+    }
+
+    struct Circle {
+      ContinuousIdxT centre;
+      X_t radius;
+    };
+
+    /**
+     * Set every cell whose centre lies inside any of the polygons (even-odd rule) to value, leaving
+     * the other cells as they are. Rows are filled in parallel, one span per edge crossing, so the
+     * cost is proportional to rows x edges rather than cells x edges.
+     */
+    void FillPolygons(const std::vector<std::vector<ContinuousIdxT>> &polygons, bool value = true, ThreadPool &pool = ThreadPool::Global()) {
+      std::vector<Y_t> ys = RowCentres();
+      _grid.MakeOwned();
+      pool.ParallelFor((size_t)_grid.rows(), [&](size_t row) {
+        Y_t y = ys[row];
+        std::vector<double> crossings;
+        for (const auto &polygon : polygons) {
+          crossings.clear();
+          for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+            const ContinuousIdxT &a = polygon[i], &b = polygon[j];
+            if ((a.y <= y) != (b.y <= y))
+              crossings.push_back(ColumnOf(a.x + (b.x - a.x) * ((y - a.y) / (b.y - a.y))));
+          }
+          std::sort(crossings.begin(), crossings.end());
+          for (size_t i = 0; i + 1 < crossings.size(); i += 2)
+            FillSpan((int)row, crossings[i], crossings[i + 1], value);
+        }
+      });
+      MarkAllChanged();
+    }
+
+    void FillPolygon(const std::vector<ContinuousIdxT> &polygon, bool value = true, ThreadPool &pool = ThreadPool::Global()) {
+      FillPolygons({ polygon }, value, pool);
+    }
+
+    /**
+     * Set every cell whose centre lies inside any of the circles to value, leaving the other cells
+     * as they are. Rows are filled in parallel, one span per circle.
+     */
+    void FillCircles(const std::vector<Circle> &circles, bool value = true, ThreadPool &pool = ThreadPool::Global()) {
+      static_assert(units::traits::is_convertible_unit<T_X, T_Y>::value, "Circles need X and Y in the same dimension");
+      std::vector<Y_t> ys = RowCentres();
+      _grid.MakeOwned();
+      pool.ParallelFor((size_t)_grid.rows(), [&](size_t row) {
+        for (const Circle &circle : circles) {
+          X_t dy{ys[row] - circle.centre.y};
+          if (units::math::abs(dy) > circle.radius) continue;
+          X_t half = units::math::sqrt(circle.radius * circle.radius - dy * dy);
+          FillSpan((int)row, ColumnOf(circle.centre.x - half), ColumnOf(circle.centre.x + half), value);
+        }
+      });
+      MarkAllChanged();
+    }
+
+    void FillCircle(ContinuousIdxT centre, X_t radius, bool value = true, ThreadPool &pool = ThreadPool::Global()) {
+      FillCircles({ Circle{ centre, radius } }, value, pool);
+    }
+
     void Load(const Eigen::MatrixXi &matrix) {
       if (matrix.cols() != _grid.cols() || matrix.rows() != _grid.rows()) {
         throw std::invalid_argument("Rows / Cols Mismatch!");
       } else {
-        _grid = matrix;
+        _grid.Load(matrix);
+        MarkAllChanged();
       }
     }
 
+    size_t CellCount() const {
+      return (size_t)(_grid.rows() * _grid.cols());
+    }
+
+    bool InBounds(Idx_t idx) const {
+      // Negative indices wrap to large unsigned values, so one compare per axis suffices.
+      return (unsigned)idx.x() < (unsigned)_grid.cols() && (unsigned)idx.y() < (unsigned)_grid.rows();
+    }
+
+    // Flat, row-major index of a cell (y * cols + x), as used by the search arrays.
+    int IndexOf(Idx_t idx) const {
+      return idx.y() * (int)_grid.cols() + idx.x();
+    }
+
+    Idx_t PositionOf(int index) const {
+      return Idx_t{ index % (int)_grid.cols(), index / (int)_grid.cols() };
+    }
+
     bool Get(Idx_t idx) {
-      if (idx.y() < 0 || idx.x() < 0)
-        return true;
-      if (idx.y() >= _grid.rows() || idx.x() >= _grid.cols())
+      if (!InBounds(idx))
         return true;
-      
-      return _grid(idx.y(), idx.x());
+
+      return _grid.Get(idx.y(), idx.x());
     }
 
     void Set(Idx_t idx, bool occupied) {
-      _grid(idx.y(), idx.x()) = occupied;
+      if (_grid.Get(idx.y(), idx.x()) == occupied)
+        return;
+
+      _grid.Set(idx.y(), idx.x(), occupied);
+      _version++;
+      if (_journal.size() >= kMaxJournal) {
+        // Too far behind to be worth replaying, anyone older than this must start over.
+        _journal.clear();
+        _journalVersion = _version;
+      } else {
+        _journal.push_back(idx);
+      }
+    }
+
+    /**
+     * Get the version of the grid. This increases on every change to the grid's cells made through
+     * Set, Fill, FillF, Load or Reset (but not through writing _grid directly).
+     */
+    uint64_t GetVersion() const {
+      return _version;
+    }
+
+    /**
+     * Call f(Idx_t) for each cell changed by Set since the given version, oldest first. Returns false
+     * if those changes are no longer known, i.e. there was a Fill, FillF, Load or Reset since, or
+     * more than kMaxJournal changes. In that case treat the whole grid as changed.
+     */
+    template<typename F>
+    bool ForEachChangeSince(uint64_t version, F &&f) const {
+      if (version < _journalVersion || version > _version)
+        return false;
+      for (size_t i = (size_t)(version - _journalVersion); i < _journal.size(); i++)
+        f(_journal[i]);
+      return true;
+    }
+
+    static constexpr size_t kMaxJournal = 4096;
+
+    // Whether any cell in the inclusive box between the two corners is occupied. Cells outside
+    // the grid count as occupied, as in Get.
+    bool AnyOccupied(Idx_t a, Idx_t b) {
+      Idx_t lo = a.cwiseMin(b), hi = a.cwiseMax(b);
+      if (!InBounds(lo) || !InBounds(hi))
+        return true;
+      if (lo.y() == hi.y())
+        return _grid.AnyInRow(lo.y(), lo.x(), hi.x());
+      return _grid.AnyInBox(lo.x(), lo.y(), hi.x(), hi.y());
     }
 
     Idx_t Discretise(ContinuousIdxT i) {
@@ -125,33 +661,86 @@ namespace wom {
     template<typename From, typename To>
     using converting_unit = typename units::unit_t<units::compound_unit<To, units::inverse<From>>>;
 
+    // O(1) after the distance field is up to date (see GetDistanceField).
     Idx_t GetClosestValidNode(Idx_t start) {
-      std::unordered_set<Idx_t, detail::matrix_hash<Idx_t>> visited;
-      visited.insert(start);
+      if (!Get(start))
+        return start;
 
-      std::deque<Idx_t> q;
-      q.push_front(start);
+      const DistanceField &field = GetDistanceField();
+      if (field.Empty())
+        return start;
 
-      while (!q.empty()) {
-        Idx_t current = q.back();
-        q.pop_back();
+      // Cells outside the grid snap to the nearest edge cell first.
+      Idx_t clamped = start.cwiseMax(Idx_t{0, 0}).cwiseMin(Idx_t{(int)_grid.cols() - 1, (int)_grid.rows() - 1});
+      int nearest = field.NearestFree(clamped.x(), clamped.y());
+      return nearest == DistanceField::npos ? start : PositionOf(nearest);
+    }
 
-        if (!Get(current)) {
-          return current;
-        } else {
-          for (int dx = -1; dx <= 1; dx++) {
-            for (int dy = -1; dy <= 1; dy++) {
-              Idx_t newPos = current + Idx_t{ dx, dy };
-              if (!visited.contains(newPos)) {
-                visited.insert(newPos);
-                q.push_front(newPos);
-              }
-            }
-          }
+    /**
+     * Get the distance transform of the grid, first bringing it up to date with any changes.
+     * Distances are in X units if X and Y are convertible units, otherwise in cells.
+     *
+     * The first call is O(cells). After that, changes made through Set only redo the columns they
+     * touched plus one pass over the rows; Fill, FillF, Load and Reset redo the whole field.
+     * Concurrent callers wait for one refresh; the field stays valid until the grid next changes.
+     */
+    const DistanceField &GetDistanceField() {
+      std::lock_guard<std::mutex> lock{ _distanceMutex };
+      if (!_distance.Empty() && _distanceVersion == _version)
+        return _distance;
+
+      auto occupied = [this](int x, int y) { return _grid.Get(y, x); };
+      std::vector<int> dirtyColumns;
+      bool incremental = !_distance.Empty() && _distance.Cols() == _grid.cols() && _distance.Rows() == _grid.rows()
+        && ForEachChangeSince(_distanceVersion, [&dirtyColumns](Idx_t changed) { dirtyColumns.push_back(changed.x()); });
+
+      if (incremental) {
+        std::sort(dirtyColumns.begin(), dirtyColumns.end());
+        dirtyColumns.erase(std::unique(dirtyColumns.begin(), dirtyColumns.end()), dirtyColumns.end());
+        _distance.Update(dirtyColumns, occupied);
+      } else {
+        double cellWidth = 1, cellHeight = 1;
+        if constexpr (units::traits::is_convertible_unit<T_X, T_Y>::value) {
+          cellWidth = ((_xmax - _xmin) / (double)_grid.cols()).value();
+          cellHeight = X_t{(_ymax - _ymin) / (double)_grid.rows()}.value();
         }
+        _distance.Rebuild((int)_grid.cols(), (int)_grid.rows(), cellWidth, cellHeight, occupied);
       }
+      _distanceVersion = _version;
+      return _distance;
+    }
 
-      return start;
+    /**
+     * Get the distance from the centre of the cell to the nearest occupied cell or the edge of the
+     * grid. 0 for occupied cells.
+     */
+    X_t GetClearance(Idx_t idx) {
+      static_assert(units::traits::is_convertible_unit<T_X, T_Y>::value, "Clearance requires X and Y in the same dimension");
+      if (!InBounds(idx))
+        return X_t{0};
+      return X_t{GetDistanceField().Clearance(idx.x(), idx.y())};
+    }
+
+    /**
+     * Whether a round footprint of the given radius centred on the cell is clear of occupied cells.
+     */
+    bool IsClear(Idx_t idx, X_t radius) {
+      return GetClearance(idx) > radius;
+    }
+
+    /**
+     * Get a copy of the grid with every cell that is not clear for the given footprint radius
+     * marked occupied, for planning with the robot's size taken into account.
+     */
+    DiscretisedOccupancyGrid Inflated(X_t radius) {
+      static_assert(units::traits::is_convertible_unit<T_X, T_Y>::value, "Inflation requires X and Y in the same dimension");
+      GetDistanceField();
+      DiscretisedOccupancyGrid inflated = *this;
+      for (int y = 0; y < _grid.rows(); y++)
+        for (int x = 0; x < _grid.cols(); x++)
+          if (!(X_t{_distance.Clearance(x, y)} > radius)) inflated._grid.Set(y, x, true);
+      inflated.MarkAllChanged();
+      return inflated;
     }
 
     // Will return a path from the closest non-obstacle nodes at the start and end.
@@ -160,72 +749,307 @@ namespace wom {
       return AStarStrict<CostT>(GetClosestValidNode(start), GetClosestValidNode(end), dxCost, dyCost);
     }
 
+    // As above, but using the given workspace and writing into path, which is cleared first.
+    // Does not allocate once the workspace and path have grown to size.
+    template<typename CostT>
+    bool AStar(Idx_t start, Idx_t end, converting_unit<T_X, CostT> dxCost, converting_unit<T_Y, CostT> dyCost, GridSearchWorkspace &workspace, std::vector<GridPathNode<CostT>> &path) {
+      return AStarStrict<CostT>(GetClosestValidNode(start), GetClosestValidNode(end), dxCost, dyCost, workspace, path);
+    }
+
     // Will return a blank path if either the start or the end are in obstacles.
+    // Searches in a workspace private to the calling thread, so several threads may search the same
+    // grid at once as long as none of them changes it.
     template<typename CostT>
     std::deque<GridPathNode<CostT>> AStarStrict(Idx_t start, Idx_t end, converting_unit<T_X, CostT> dxCost, converting_unit<T_Y, CostT> dyCost) {
-      using cost_t = units::unit_t<CostT>;
-      using node_t = std::shared_ptr<AStarNode<CostT>>;
-
-      std::vector<node_t> allNodes;
-      allNodes.push_back(std::make_shared<AStarNode<CostT>>(
-        start, nullptr, cost_t{0}, Cost<CostT>(start, end, dxCost, dyCost)
-      ));
-
-      std::vector<node_t> openSet;
-      openSet.push_back(allNodes[0]);
-
-      while (!openSet.empty()) {
-        auto currentIt = std::min_element(openSet.cbegin(), openSet.cend(), [](auto a, auto b) { return a->fScore < b->fScore; });
-        node_t current = *currentIt;
-        openSet.erase(currentIt);
-        if (current->position == end) {
-          std::deque<GridPathNode<CostT>> queue;
-          queue.push_front(GridPathNode<CostT> {
-            CenterOf(current->position),
-            current->gScore
-          });
-
-          while (current->parent) {
-            queue.push_front(GridPathNode<CostT> {
-              CenterOf(current->parent->position),
-              current->parent->gScore
-            });
-            current = current->parent;
-          }
+      std::deque<GridPathNode<CostT>> queue;
+      GridSearchWorkspace &ws = ThreadWorkspace();
+      int last = SearchAStar<CostT>(start, end, dxCost, dyCost, ws);
+      TracePath<CostT>(last, dxCost, dyCost, ws, [&queue](GridPathNode<CostT> node) { queue.push_front(node); });
+      return queue;
+    }
 
-          return queue;
-        } else {
-          for (int dx = -1; dx <= 1; dx++) {
-            for (int dy = -1; dy <= 1; dy++) {
-              Idx_t newPos = current->position + Idx_t{ dx, dy };
-              // Find neighbour, or create if not exists.
-              auto neighbourIt = std::find_if(allNodes.cbegin(), allNodes.cend(), [newPos](auto node) { return node->position == newPos; });
-              if (neighbourIt == allNodes.cend()) {
-                allNodes.push_back(std::make_shared<AStarNode<CostT>>(
-                  newPos, nullptr, cost_t{1e9}, cost_t{1e9}
-                ));
-                neighbourIt = allNodes.cend() - 1;
-              }
-              node_t neighbour = *neighbourIt;
-
-              if (newPos != current->position && !Get(newPos)) {
-                cost_t tentative = current->gScore + Cost<CostT>(current->position, newPos, dxCost, dyCost);
-
-                if (tentative < neighbour->gScore) {
-                  neighbour->parent = current;
-                  neighbour->gScore = tentative;
-                  neighbour->fScore = tentative + Cost<CostT>(newPos, end, dxCost, dyCost);
-                  if (std::find(openSet.cbegin(), openSet.cend(), neighbour) == openSet.cend()) {
-                    openSet.push_back(neighbour);
-                  }
-                }
-              }
+    template<typename CostT>
+    bool AStarStrict(Idx_t start, Idx_t end, converting_unit<T_X, CostT> dxCost, converting_unit<T_Y, CostT> dyCost, GridSearchWorkspace &workspace, std::vector<GridPathNode<CostT>> &path) {
+      path.clear();
+      int last = SearchAStar<CostT>(start, end, dxCost, dyCost, workspace);
+      TracePath<CostT>(last, dxCost, dyCost, workspace, [&path](GridPathNode<CostT> node) { path.push_back(node); });
+      std::reverse(path.begin(), path.end());
+      return !path.empty();
+    }
+
+    /**
+     * Run AStar for every (start, end) pair concurrently on the pool, returning the paths in the
+     * same order. Each pool thread searches with its own workspace, so the grid must not be
+     * changed until this returns. Start and end are moved to the closest valid nodes as with AStar.
+     */
+    template<typename CostT>
+    std::vector<std::deque<GridPathNode<CostT>>> AStarBatch(std::span<const std::pair<Idx_t, Idx_t>> queries, converting_unit<T_X, CostT> dxCost, converting_unit<T_Y, CostT> dyCost, ThreadPool &pool = ThreadPool::Global()) {
+      // Resolve the endpoints up front, as GetClosestValidNode may rebuild the distance field.
+      std::vector<std::pair<Idx_t, Idx_t>> resolved;
+      resolved.reserve(queries.size());
+      for (const auto &[start, end] : queries)
+        resolved.emplace_back(GetClosestValidNode(start), GetClosestValidNode(end));
+      return AStarBatchStrict<CostT>(resolved, dxCost, dyCost, pool);
+    }
+
+    // Will return a blank path for any query whose start or end are in obstacles.
+    template<typename CostT>
+    std::vector<std::deque<GridPathNode<CostT>>> AStarBatchStrict(std::span<const std::pair<Idx_t, Idx_t>> queries, converting_unit<T_X, CostT> dxCost, converting_unit<T_Y, CostT> dyCost, ThreadPool &pool = ThreadPool::Global()) {
+      std::vector<std::deque<GridPathNode<CostT>>> paths(queries.size());
+      // Take the cached workspaces for this call rather than holding _batchMutex across the
+      // dispatch: ParallelFor waits on the pool, whose jobs may be batching on this grid too. A
+      // concurrent batch finds the cache empty and searches with fresh workspaces.
+      std::vector<GridSearchWorkspace> workspaces;
+      {
+        std::lock_guard<std::mutex> lock{ _batchMutex };
+        workspaces.swap(_batchWorkspaces);
+      }
+      if (workspaces.size() < pool.Concurrency())
+        workspaces.resize(pool.Concurrency());
+
+      pool.ParallelFor(queries.size(), [&](size_t i, size_t worker) {
+        GridSearchWorkspace &ws = workspaces[worker];
+        std::deque<GridPathNode<CostT>> &path = paths[i];
+        int last = SearchAStar<CostT>(queries[i].first, queries[i].second, dxCost, dyCost, ws);
+        TracePath<CostT>(last, dxCost, dyCost, ws, [&path](GridPathNode<CostT> node) { path.push_front(node); });
+      });
+
+      std::lock_guard<std::mutex> lock{ _batchMutex };
+      if (_batchWorkspaces.size() < workspaces.size())
+        _batchWorkspaces.swap(workspaces);
+      return paths;
+    }
+
+    /**
+     * Jump Point Search. Gives a path of the same cost as AStar (under the same 8-connected move
+     * model and Cost metric), but only expands "jump points" where the optimal path may turn, so
+     * open areas are crossed without expanding every cell. Only valid for uniform-cost grids.
+     * 
+     * The returned path contains every cell along the way, as with AStar.
+     */
+    template<typename CostT>
+    std::deque<GridPathNode<CostT>> JPS(Idx_t start, Idx_t end, converting_unit<T_X, CostT> dxCost, converting_unit<T_Y, CostT> dyCost) {
+      return JPSStrict<CostT>(GetClosestValidNode(start), GetClosestValidNode(end), dxCost, dyCost);
+    }
+
+    template<typename CostT>
+    bool JPS(Idx_t start, Idx_t end, converting_unit<T_X, CostT> dxCost, converting_unit<T_Y, CostT> dyCost, GridSearchWorkspace &workspace, std::vector<GridPathNode<CostT>> &path) {
+      return JPSStrict<CostT>(GetClosestValidNode(start), GetClosestValidNode(end), dxCost, dyCost, workspace, path);
+    }
+
+    // Will return a blank path if either the start or the end are in obstacles.
+    template<typename CostT>
+    std::deque<GridPathNode<CostT>> JPSStrict(Idx_t start, Idx_t end, converting_unit<T_X, CostT> dxCost, converting_unit<T_Y, CostT> dyCost) {
+      std::deque<GridPathNode<CostT>> queue;
+      GridSearchWorkspace &ws = ThreadWorkspace();
+      int last = SearchJPS<CostT>(start, end, dxCost, dyCost, ws);
+      TracePath<CostT>(last, dxCost, dyCost, ws, [&queue](GridPathNode<CostT> node) { queue.push_front(node); });
+      return queue;
+    }
+
+    template<typename CostT>
+    bool JPSStrict(Idx_t start, Idx_t end, converting_unit<T_X, CostT> dxCost, converting_unit<T_Y, CostT> dyCost, GridSearchWorkspace &workspace, std::vector<GridPathNode<CostT>> &path) {
+      path.clear();
+      int last = SearchJPS<CostT>(start, end, dxCost, dyCost, workspace);
+      TracePath<CostT>(last, dxCost, dyCost, workspace, [&path](GridPathNode<CostT> node) { path.push_back(node); });
+      std::reverse(path.begin(), path.end());
+      return !path.empty();
+    }
+
+    /**
+     * Lazy Theta*, an any-angle variant of A*. Nodes may take any visible ancestor as their parent
+     * rather than only a neighbour, so the path is a handful of straight segments between corners
+     * instead of an 8-connected staircase, and is usually shorter than the AStar path.
+     *
+     * The returned path only contains the turning points.
+     */
+    template<typename CostT>
+    std::deque<GridPathNode<CostT>> ThetaStar(Idx_t start, Idx_t end, converting_unit<T_X, CostT> dxCost, converting_unit<T_Y, CostT> dyCost) {
+      return ThetaStarStrict<CostT>(GetClosestValidNode(start), GetClosestValidNode(end), dxCost, dyCost);
+    }
+
+    template<typename CostT>
+    bool ThetaStar(Idx_t start, Idx_t end, converting_unit<T_X, CostT> dxCost, converting_unit<T_Y, CostT> dyCost, GridSearchWorkspace &workspace, std::vector<GridPathNode<CostT>> &path) {
+      return ThetaStarStrict<CostT>(GetClosestValidNode(start), GetClosestValidNode(end), dxCost, dyCost, workspace, path);
+    }
+
+    // Will return a blank path if either the start or the end are in obstacles.
+    template<typename CostT>
+    std::deque<GridPathNode<CostT>> ThetaStarStrict(Idx_t start, Idx_t end, converting_unit<T_X, CostT> dxCost, converting_unit<T_Y, CostT> dyCost) {
+      std::deque<GridPathNode<CostT>> queue;
+      GridSearchWorkspace &ws = ThreadWorkspace();
+      int last = SearchThetaStar<CostT>(start, end, dxCost, dyCost, ws);
+      for (int current = last; current >= 0; current = ws.At(current).parent)
+        queue.push_front(GridPathNode<CostT>{ CenterOf(PositionOf(current)), units::unit_t<CostT>{ws.At(current).gScore} });
+      return queue;
+    }
+
+    template<typename CostT>
+    bool ThetaStarStrict(Idx_t start, Idx_t end, converting_unit<T_X, CostT> dxCost, converting_unit<T_Y, CostT> dyCost, GridSearchWorkspace &workspace, std::vector<GridPathNode<CostT>> &path) {
+      path.clear();
+      int last = SearchThetaStar<CostT>(start, end, dxCost, dyCost, workspace);
+      for (int current = last; current >= 0; current = workspace.At(current).parent)
+        path.push_back(GridPathNode<CostT>{ CenterOf(PositionOf(current)), units::unit_t<CostT>{workspace.At(current).gScore} });
+      std::reverse(path.begin(), path.end());
+      return !path.empty();
+    }
+
+    /**
+     * Whether the straight line between the centres of cells a and b only passes through free
+     * cells. Touching a cell only at its corner does not count as passing through it, matching
+     * the diagonal moves allowed by AStar. Each row crossed is tested as one span, which is a
+     * handful of word tests with BitPackedOccupancy.
+     */
+    bool LineOfSight(Idx_t a, Idx_t b) {
+      if (!InBounds(a) || !InBounds(b))
+        return false;
+      return ForEachLineSpan(a, b, [this](int y, int x0, int x1) { return !_grid.AnyInRow(y, x0, x1); });
+    }
+
+    /**
+     * Shortcut smoothing: drop every waypoint that can be skipped with a clear straight line,
+     * keeping the start and end. Useful on AStar or JPS paths, which step one cell at a time.
+     * Lines through cells with a traversal cost are not taken. Costs are recomputed along the new
+     * segments.
+     */
+    template<typename CostT>
+    std::deque<GridPathNode<CostT>> Shortcut(const std::deque<GridPathNode<CostT>> &path, converting_unit<T_X, CostT> dxCost, converting_unit<T_Y, CostT> dyCost) {
+      std::deque<GridPathNode<CostT>> smoothed;
+      if (path.empty())
+        return smoothed;
+
+      size_t anchor = 0;
+      Idx_t anchorPos = Discretise(path.front().position);
+      smoothed.push_back(GridPathNode<CostT>{ path.front().position, units::unit_t<CostT>{0} });
+      while (anchor + 1 < path.size()) {
+        size_t next = anchor + 1;
+        while (next + 1 < path.size() && ClearLine(anchorPos, Discretise(path[next + 1].position)))
+          next++;
+
+        Idx_t nextPos = Discretise(path[next].position);
+        auto cost = smoothed.back().cost + Cost<CostT>(anchorPos, nextPos, dxCost, dyCost) * (next == anchor + 1 ? _traversal.Multiplier(IndexOf(nextPos)) : 1.0);
+        smoothed.push_back(GridPathNode<CostT>{ path[next].position, cost });
+        anchor = next;
+        anchorPos = nextPos;
+      }
+      return smoothed;
+    }
+
+    /* TRAVERSAL COSTS */
+
+    /**
+     * Set the base traversal cost of a cell (see TraversalCostLayer). AStar, AStarBatch, ThetaStar,
+     * the cost-to-goal fields and AnytimePlanner fold these into their edge costs. JPS falls back
+     * to AStar while any are set. IncrementalPlanner and HierarchicalPlanner only use occupancy.
+     * Out of bounds cells are ignored, as GetTraversalCost reads them as 0.
+     */
+    void SetTraversalCost(Idx_t idx, TraversalT cost) {
+      if (!InBounds(idx))
+        return;
+      _traversal.Set(CellCount(), IndexOf(idx), cost);
+    }
+
+    /**
+     * Set a traversal cost that lasts until ClearTransientTraversalCosts, for cells that change
+     * every tick. Costs O(1) to set and to clear again. Out of bounds cells are ignored.
+     */
+    void SetTransientTraversalCost(Idx_t idx, TraversalT cost) {
+      if (!InBounds(idx))
+        return;
+      _traversal.SetTransient(CellCount(), IndexOf(idx), cost);
+    }
+
+    void ClearTransientTraversalCosts() {
+      _traversal.ClearTransient();
+    }
+
+    // Drop all traversal costs, returning to purely geometric costs.
+    void ClearTraversalCosts() {
+      _traversal.Clear();
+    }
+
+    TraversalT GetTraversalCost(Idx_t idx) const {
+      return InBounds(idx) ? _traversal.Get(IndexOf(idx)) : TraversalT{0};
+    }
+
+    // The factor applied to the cost of moving into idx.
+    double GetTraversalMultiplier(Idx_t idx) const {
+      return InBounds(idx) ? _traversal.Multiplier(IndexOf(idx)) : 1.0;
+    }
+
+    // Entering a cell with traversal cost c costs (1 + c * scale) times the geometric step. Throws
+    // std::invalid_argument if scale is negative.
+    void SetTraversalScale(double scale) {
+      _traversal.SetScale(scale);
+    }
+
+    uint64_t GetTraversalVersion() const {
+      return _traversal.GetVersion();
+    }
+
+    /**
+     * Cost of the cheapest path from start to goal, read from a cost-to-goal field. The field is
+     * built for the whole grid by one reverse Dijkstra sweep from the goal, and cached (per goal,
+     * step costs, grid and traversal versions), so asking from many starts to the same goal only
+     * pays once.
+     * Infinite if there is no path.
+     */
+    template<typename CostT>
+    units::unit_t<CostT> CostToGoal(Idx_t start, Idx_t goal, converting_unit<T_X, CostT> dxCost, converting_unit<T_Y, CostT> dyCost) {
+      if (!InBounds(start))
+        return units::unit_t<CostT>{std::numeric_limits<double>::infinity()};
+      std::lock_guard<std::mutex> lock{ _costFieldMutex };
+      return units::unit_t<CostT>{GetCostField<CostT>(goal, dxCost, dyCost).cost[IndexOf(start)]};
+    }
+
+    // Will return a path from the closest non-obstacle nodes at the start and goal.
+    template<typename CostT>
+    std::deque<GridPathNode<CostT>> GoalFieldPath(Idx_t start, Idx_t goal, converting_unit<T_X, CostT> dxCost, converting_unit<T_Y, CostT> dyCost) {
+      return GoalFieldPathStrict<CostT>(GetClosestValidNode(start), GetClosestValidNode(goal), dxCost, dyCost);
+    }
+
+    /**
+     * Optimal path from start to goal by descending the cached cost-to-goal field, in time
+     * proportional to the path length once the field is built. Same cost as AStarStrict.
+     * Will return a blank path if either the start or the goal are in obstacles.
+     */
+    template<typename CostT>
+    std::deque<GridPathNode<CostT>> GoalFieldPathStrict(Idx_t start, Idx_t goal, converting_unit<T_X, CostT> dxCost, converting_unit<T_Y, CostT> dyCost) {
+      std::deque<GridPathNode<CostT>> path;
+      if (Get(start) || Get(goal))
+        return path;
+
+      // Held for the walk, as another goal could evict the field.
+      std::lock_guard<std::mutex> lock{ _costFieldMutex };
+      const CostField &field = GetCostField<CostT>(goal, dxCost, dyCost);
+      int current = IndexOf(start);
+      if (std::isinf(field.cost[current]))
+        return path;
+
+      double g = 0;
+      Idx_t pos = start;
+      path.push_back(GridPathNode<CostT>{ CenterOf(pos), units::unit_t<CostT>{0} });
+      while (pos != goal) {
+        Idx_t best = pos;
+        double bestCost = std::numeric_limits<double>::infinity(), bestStep = 0;
+        for (int dx = -1; dx <= 1; dx++) {
+          for (int dy = -1; dy <= 1; dy++) {
+            Idx_t next = pos + Idx_t{ dx, dy };
+            if ((dx == 0 && dy == 0) || !InBounds(next)) continue;
+            double step = field.stepCost[(dx + 1) * 3 + (dy + 1)] * _traversal.Multiplier(IndexOf(next));
+            double c = step + field.cost[IndexOf(next)];
+            if (c < bestCost) {
+              bestCost = c;
+              bestStep = step;
+              best = next;
             }
           }
         }
+        pos = best;
+        g += bestStep;
+        path.push_back(GridPathNode<CostT>{ CenterOf(pos), units::unit_t<CostT>{g} });
       }
-
-      return std::deque<GridPathNode<CostT>>{};
+      return path;
     }
 
     template<typename CostT>
@@ -242,6 +1066,440 @@ namespace wom {
 
     X_t _xmin, _xmax;
     Y_t _ymin, _ymax;
-    Eigen::MatrixXi _grid;
+    Storage _grid;
+
+   private:
+    // Workspace for the searches that don't take one. Shared by every grid of this type on the
+    // calling thread, which is fine as a workspace is reset at the start of each search.
+    static GridSearchWorkspace &ThreadWorkspace() {
+      static thread_local GridSearchWorkspace workspace;
+      return workspace;
+    }
+
+    // Runs A* into the workspace, returning the flat index of the end node (follow parents
+    // back to the start), or -1 if there is no path.
+    template<typename CostT>
+    int SearchAStar(Idx_t start, Idx_t end, converting_unit<T_X, CostT> dxCost, converting_unit<T_Y, CostT> dyCost, GridSearchWorkspace &ws) {
+      using key_t = GridSearchWorkspace::key_t;
+
+      ws.Begin(CellCount());
+      if (Get(start) || Get(end))
+        return -1;
+
+      // Step costs only depend on direction, so compute them once rather than per expansion.
+      std::array<double, 9> stepCost;
+      for (int dx = -1; dx <= 1; dx++)
+        for (int dy = -1; dy <= 1; dy++)
+          stepCost[(dx + 1) * 3 + (dy + 1)] = Cost<CostT>(Idx_t{0, 0}, Idx_t{dx, dy}, dxCost, dyCost).value();
+
+      const int startIdx = IndexOf(start), endIdx = IndexOf(end);
+      ws.At(startIdx).gScore = 0;
+      double h0 = Cost<CostT>(start, end, dxCost, dyCost).value();
+      ws.openSet.Push(startIdx, key_t{ h0, h0 });
+
+      while (!ws.openSet.Empty()) {
+        int current = ws.openSet.Pop();
+        if (current == endIdx)
+          return current;
+
+        GridSearchWorkspace::Node &currentNode = ws.At(current);
+        currentNode.closed = true;
+        ws.Expanded();
+
+        Idx_t currentPos = PositionOf(current);
+        for (int dx = -1; dx <= 1; dx++) {
+          for (int dy = -1; dy <= 1; dy++) {
+            if (dx == 0 && dy == 0) continue;
+            Idx_t newPos = currentPos + Idx_t{ dx, dy };
+            if (Get(newPos)) continue;
+
+            int neighbour = IndexOf(newPos);
+            GridSearchWorkspace::Node &neighbourNode = ws.At(neighbour);
+            if (neighbourNode.closed) continue;
+
+            double tentative = currentNode.gScore + stepCost[(dx + 1) * 3 + (dy + 1)] * _traversal.Multiplier(neighbour);
+            if (tentative < neighbourNode.gScore) {
+              neighbourNode.parent = current;
+              neighbourNode.gScore = tentative;
+              double h = Cost<CostT>(newPos, end, dxCost, dyCost).value();
+              ws.openSet.Push(neighbour, key_t{ tentative + h, h });
+            }
+          }
+        }
+      }
+
+      return -1;
+    }
+
+    // Jump along a straight (dx or dy zero) line from pos, returning the next jump point or -1.
+    int JumpStraight(Idx_t pos, int dx, int dy, Idx_t end) {
+      while (true) {
+        pos += Idx_t{ dx, dy };
+        if (Get(pos)) return -1;
+        if (pos == end) return IndexOf(pos);
+
+        // A neighbour beside us is blocked but the cell beyond it is open: we have a forced neighbour.
+        if (dx != 0) {
+          if ((Get({pos.x(), pos.y() + 1}) && !Get({pos.x() + dx, pos.y() + 1}))
+            || (Get({pos.x(), pos.y() - 1}) && !Get({pos.x() + dx, pos.y() - 1})))
+            return IndexOf(pos);
+        } else {
+          if ((Get({pos.x() + 1, pos.y()}) && !Get({pos.x() + 1, pos.y() + dy}))
+            || (Get({pos.x() - 1, pos.y()}) && !Get({pos.x() - 1, pos.y() + dy})))
+            return IndexOf(pos);
+        }
+      }
+    }
+
+    // Jump from pos in direction (dx, dy), returning the next jump point or -1.
+    int Jump(Idx_t pos, int dx, int dy, Idx_t end) {
+      if (dx == 0 || dy == 0)
+        return JumpStraight(pos, dx, dy, end);
+
+      while (true) {
+        pos += Idx_t{ dx, dy };
+        if (Get(pos)) return -1;
+        if (pos == end) return IndexOf(pos);
+
+        if ((!Get({pos.x() - dx, pos.y() + dy}) && Get({pos.x() - dx, pos.y()}))
+          || (!Get({pos.x() + dx, pos.y() - dy}) && Get({pos.x(), pos.y() - dy})))
+          return IndexOf(pos);
+
+        // Diagonal moves stop wherever either straight component would find a jump point.
+        if (JumpStraight(pos, dx, 0, end) >= 0 || JumpStraight(pos, 0, dy, end) >= 0)
+          return IndexOf(pos);
+      }
+    }
+
+    // As SearchAStar, but only expanding jump points. Parents link jump points, which always lie
+    // on a straight or diagonal line from one another.
+    template<typename CostT>
+    int SearchJPS(Idx_t start, Idx_t end, converting_unit<T_X, CostT> dxCost, converting_unit<T_Y, CostT> dyCost, GridSearchWorkspace &ws) {
+      using key_t = GridSearchWorkspace::key_t;
+
+      // Jumping relies on uniform step costs.
+      if (!_traversal.Empty())
+        return SearchAStar<CostT>(start, end, dxCost, dyCost, ws);
+
+      ws.Begin(CellCount());
+      if (Get(start) || Get(end))
+        return -1;
+
+      const int startIdx = IndexOf(start), endIdx = IndexOf(end);
+      ws.At(startIdx).gScore = 0;
+      double h0 = Cost<CostT>(start, end, dxCost, dyCost).value();
+      ws.openSet.Push(startIdx, key_t{ h0, h0 });
+
+      std::array<Idx_t, 8> directions;
+      while (!ws.openSet.Empty()) {
+        int current = ws.openSet.Pop();
+        if (current == endIdx)
+          return current;
+
+        GridSearchWorkspace::Node &currentNode = ws.At(current);
+        currentNode.closed = true;
+        ws.Expanded();
+
+        Idx_t pos = PositionOf(current);
+        int nDirections = 0;
+
+        if (currentNode.parent < 0) {
+          for (int dx = -1; dx <= 1; dx++)
+            for (int dy = -1; dy <= 1; dy++)
+              if (dx != 0 || dy != 0) directions[nDirections++] = Idx_t{ dx, dy };
+        } else {
+          // Prune to the natural and forced neighbours given the direction we arrived from.
+          Idx_t d = (pos - PositionOf(currentNode.parent)).cwiseSign();
+          int dx = d.x(), dy = d.y();
+          if (dx != 0 && dy != 0) {
+            directions[nDirections++] = Idx_t{ 0, dy };
+            directions[nDirections++] = Idx_t{ dx, 0 };
+            directions[nDirections++] = Idx_t{ dx, dy };
+            if (Get({pos.x() - dx, pos.y()})) directions[nDirections++] = Idx_t{ -dx, dy };
+            if (Get({pos.x(), pos.y() - dy})) directions[nDirections++] = Idx_t{ dx, -dy };
+          } else if (dx != 0) {
+            directions[nDirections++] = Idx_t{ dx, 0 };
+            if (Get({pos.x(), pos.y() + 1})) directions[nDirections++] = Idx_t{ dx, 1 };
+            if (Get({pos.x(), pos.y() - 1})) directions[nDirections++] = Idx_t{ dx, -1 };
+          } else {
+            directions[nDirections++] = Idx_t{ 0, dy };
+            if (Get({pos.x() + 1, pos.y()})) directions[nDirections++] = Idx_t{ 1, dy };
+            if (Get({pos.x() - 1, pos.y()})) directions[nDirections++] = Idx_t{ -1, dy };
+          }
+        }
+
+        for (int i = 0; i < nDirections; i++) {
+          int jumpPoint = Jump(pos, directions[i].x(), directions[i].y(), end);
+          if (jumpPoint < 0) continue;
+
+          GridSearchWorkspace::Node &jumpNode = ws.At(jumpPoint);
+          if (jumpNode.closed) continue;
+
+          Idx_t jumpPos = PositionOf(jumpPoint);
+          double tentative = currentNode.gScore + Cost<CostT>(pos, jumpPos, dxCost, dyCost).value();
+          if (tentative < jumpNode.gScore) {
+            jumpNode.parent = current;
+            jumpNode.gScore = tentative;
+            double h = Cost<CostT>(jumpPos, end, dxCost, dyCost).value();
+            ws.openSet.Push(jumpPoint, key_t{ tentative + h, h });
+          }
+        }
+      }
+
+      return -1;
+    }
+
+    // Call f(y, x0, x1) for each row span crossed by the line between the centres of a and b (both
+    // in bounds), stopping as soon as f returns false. Returns whether f always returned true.
+    template<typename F>
+    bool ForEachLineSpan(Idx_t a, Idx_t b, F &&f) {
+      if (a.y() == b.y())
+        return f(a.y(), std::min(a.x(), b.x()), std::max(a.x(), b.x()));
+
+      // Work in cell units with centres at +0.5, walking the rows from a to b.
+      constexpr double eps = 1e-9;
+      if (a.y() > b.y()) std::swap(a, b);
+      double slope = (double)(b.x() - a.x()) / (b.y() - a.y());
+      int xmin = std::min(a.x(), b.x()), xmax = std::max(a.x(), b.x());
+      for (int y = a.y(); y <= b.y(); y++) {
+        double y0 = std::max((double)y, a.y() + 0.5), y1 = std::min(y + 1.0, b.y() + 0.5);
+        double xa = a.x() + 0.5 + (y0 - a.y() - 0.5) * slope, xb = a.x() + 0.5 + (y1 - a.y() - 0.5) * slope;
+        int x0 = std::max(xmin, (int)std::floor(std::min(xa, xb) + eps));
+        int x1 = std::min(xmax, (int)std::floor(std::max(xa, xb) - eps));
+        if (x1 < x0) x1 = x0;
+        if (!f(y, x0, x1)) return false;
+      }
+      return true;
+    }
+
+    // Line of sight through cells without traversal costs, so that the straight move costs its length.
+    bool ClearLine(Idx_t a, Idx_t b) {
+      if (!LineOfSight(a, b))
+        return false;
+      if (_traversal.Empty())
+        return true;
+      return ForEachLineSpan(a, b, [this](int y, int x0, int x1) {
+        for (int x = x0; x <= x1; x++)
+          if (_traversal.Get(IndexOf(Idx_t{x, y})) != 0) return false;
+        return true;
+      });
+    }
+
+    // Lazy Theta*: a neighbour is optimistically given the current node's parent, and the line of
+    // sight is only checked when it is expanded, falling back to the best closed neighbour if blocked.
+    // Only lines through cells without traversal costs are taken, so their cost is their length.
+    template<typename CostT>
+    int SearchThetaStar(Idx_t start, Idx_t end, converting_unit<T_X, CostT> dxCost, converting_unit<T_Y, CostT> dyCost, GridSearchWorkspace &ws) {
+      using key_t = GridSearchWorkspace::key_t;
+
+      ws.Begin(CellCount());
+      if (Get(start) || Get(end))
+        return -1;
+
+      std::array<double, 9> stepCost;
+      for (int dx = -1; dx <= 1; dx++)
+        for (int dy = -1; dy <= 1; dy++)
+          stepCost[(dx + 1) * 3 + (dy + 1)] = Cost<CostT>(Idx_t{0, 0}, Idx_t{dx, dy}, dxCost, dyCost).value();
+
+      const int startIdx = IndexOf(start), endIdx = IndexOf(end);
+      ws.At(startIdx).gScore = 0;
+      double h0 = Cost<CostT>(start, end, dxCost, dyCost).value();
+      ws.openSet.Push(startIdx, key_t{ h0, h0 });
+
+      while (!ws.openSet.Empty()) {
+        int current = ws.openSet.Pop();
+        GridSearchWorkspace::Node &currentNode = ws.At(current);
+        Idx_t currentPos = PositionOf(current);
+
+        if (currentNode.parent >= 0 && !ClearLine(PositionOf(currentNode.parent), currentPos)) {
+          currentNode.gScore = std::numeric_limits<double>::infinity();
+          for (int dx = -1; dx <= 1; dx++) {
+            for (int dy = -1; dy <= 1; dy++) {
+              if (dx == 0 && dy == 0) continue;
+              Idx_t pos = currentPos - Idx_t{ dx, dy };
+              if (Get(pos)) continue;
+
+              int neighbour = IndexOf(pos);
+              GridSearchWorkspace::Node &neighbourNode = ws.At(neighbour);
+              double g = neighbourNode.gScore + stepCost[(dx + 1) * 3 + (dy + 1)] * _traversal.Multiplier(current);
+              if (neighbourNode.closed && g < currentNode.gScore) {
+                currentNode.gScore = g;
+                currentNode.parent = neighbour;
+              }
+            }
+          }
+        }
+
+        if (current == endIdx)
+          return current;
+
+        currentNode.closed = true;
+        ws.Expanded();
+
+        int via = currentNode.parent >= 0 ? currentNode.parent : current;
+        Idx_t viaPos = PositionOf(via);
+        double viaScore = ws.At(via).gScore;
+        for (int dx = -1; dx <= 1; dx++) {
+          for (int dy = -1; dy <= 1; dy++) {
+            if (dx == 0 && dy == 0) continue;
+            Idx_t newPos = currentPos + Idx_t{ dx, dy };
+            if (Get(newPos)) continue;
+
+            int neighbour = IndexOf(newPos);
+            GridSearchWorkspace::Node &neighbourNode = ws.At(neighbour);
+            if (neighbourNode.closed) continue;
+
+            double tentative = viaScore + Cost<CostT>(viaPos, newPos, dxCost, dyCost).value() * (via == current ? _traversal.Multiplier(neighbour) : 1.0);
+            if (tentative < neighbourNode.gScore) {
+              neighbourNode.parent = via;
+              neighbourNode.gScore = tentative;
+              double h = Cost<CostT>(newPos, end, dxCost, dyCost).value();
+              ws.openSet.Push(neighbour, key_t{ tentative + h, h });
+            }
+          }
+        }
+      }
+
+      return -1;
+    }
+
+    // Costs to reach one goal from every cell, for the step costs and grid version they were built with.
+    struct CostField {
+      int goal;
+      uint64_t version, traversalVersion;
+      std::array<double, 9> stepCost;
+      std::vector<double> cost;
+    };
+
+    static constexpr size_t kCostFieldCacheSize = 4;
+
+    // Find the field for goal in the cache, or build it with a reverse Dijkstra sweep (moves are
+    // symmetric, so the cost from the goal to a cell is the cost from that cell to the goal).
+    // The caller holds _costFieldMutex.
+    template<typename CostT>
+    const CostField &GetCostField(Idx_t goal, converting_unit<T_X, CostT> dxCost, converting_unit<T_Y, CostT> dyCost) {
+      std::array<double, 9> stepCost;
+      for (int dx = -1; dx <= 1; dx++)
+        for (int dy = -1; dy <= 1; dy++)
+          stepCost[(dx + 1) * 3 + (dy + 1)] = Cost<CostT>(Idx_t{0, 0}, Idx_t{dx, dy}, dxCost, dyCost).value();
+
+      int goalIdx = InBounds(goal) ? IndexOf(goal) : -1;
+      for (size_t i = 0; i < _costFields.size(); i++) {
+        if (_costFields[i].goal == goalIdx && _costFields[i].version == _version
+          && _costFields[i].traversalVersion == _traversal.GetVersion() && _costFields[i].stepCost == stepCost) {
+          // Most recently used first.
+          std::rotate(_costFields.begin(), _costFields.begin() + i, _costFields.begin() + i + 1);
+          return _costFields.front();
+        }
+      }
+
+      // Reuse the least recently used field's storage.
+      if (_costFields.size() < kCostFieldCacheSize) _costFields.emplace_back();
+      std::rotate(_costFields.begin(), _costFields.end() - 1, _costFields.end());
+      CostField &field = _costFields.front();
+      field.goal = goalIdx;
+      field.version = _version;
+      field.traversalVersion = _traversal.GetVersion();
+      field.stepCost = stepCost;
+      field.cost.assign(CellCount(), std::numeric_limits<double>::infinity());
+      if (goalIdx < 0 || Get(goal))
+        return field;
+
+      detail::IndexedHeap<double> &open = _costFieldOpen;
+      open.Resize(CellCount());
+      field.cost[goalIdx] = 0;
+      open.Push(goalIdx, 0);
+      while (!open.Empty()) {
+        int current = open.Pop();
+        // Stepping from a neighbour into current pays current's traversal cost.
+        double g = field.cost[current], multiplier = _traversal.Multiplier(current);
+        Idx_t pos = PositionOf(current);
+        for (int dx = -1; dx <= 1; dx++) {
+          for (int dy = -1; dy <= 1; dy++) {
+            if (dx == 0 && dy == 0) continue;
+            Idx_t next = pos + Idx_t{ dx, dy };
+            if (Get(next)) continue;
+
+            int neighbour = IndexOf(next);
+            double tentative = g + stepCost[(dx + 1) * 3 + (dy + 1)] * multiplier;
+            if (tentative < field.cost[neighbour]) {
+              field.cost[neighbour] = tentative;
+              open.Push(neighbour, tentative);
+            }
+          }
+        }
+      }
+      return field;
+    }
+
+    // Walks back from last to the start through the workspace's parent links, calling emit for
+    // every cell in reverse order. Links that skip cells (e.g. from JPS) are filled in along their line.
+    template<typename CostT, typename F>
+    void TracePath(int last, converting_unit<T_X, CostT> dxCost, converting_unit<T_Y, CostT> dyCost, GridSearchWorkspace &ws, F &&emit) {
+      for (int current = last; current >= 0; current = ws.At(current).parent) {
+        const GridSearchWorkspace::Node &node = ws.At(current);
+        Idx_t pos = PositionOf(current);
+        emit(GridPathNode<CostT> { CenterOf(pos), units::unit_t<CostT>{node.gScore} });
+
+        if (node.parent >= 0) {
+          Idx_t parentPos = PositionOf(node.parent);
+          Idx_t step = (parentPos - pos).cwiseSign();
+          double stepCost = Cost<CostT>(Idx_t{0, 0}, step, dxCost, dyCost).value();
+          double g = node.gScore;
+          for (Idx_t p = pos + step; p != parentPos; p += step) {
+            g -= stepCost;
+            emit(GridPathNode<CostT> { CenterOf(p), units::unit_t<CostT>{g} });
+          }
+        }
+      }
+    }
+
+    // Centres of each column and row, matching CenterOf.
+    std::vector<X_t> ColumnCentres() {
+      std::vector<X_t> xs;
+      for (int x = 0; x < _grid.cols(); x++) xs.push_back(CenterOf(Idx_t{x, 0}).x);
+      return xs;
+    }
+
+    std::vector<Y_t> RowCentres() {
+      std::vector<Y_t> ys;
+      for (int y = 0; y < _grid.rows(); y++) ys.push_back(CenterOf(Idx_t{0, y}).y);
+      return ys;
+    }
+
+    // Continuous column coordinate of x, with cell c spanning [c, c + 1).
+    double ColumnOf(X_t x) const {
+      return detail::remap(x, _xmin, _xmax, 0.0, (double)_grid.cols());
+    }
+
+    // Fill the cells of row y whose centres lie within the column coordinates [from, to].
+    void FillSpan(int y, double from, double to, bool value) {
+      int x0 = std::max(0, (int)std::ceil(from - 0.5));
+      int x1 = std::min((int)_grid.cols() - 1, (int)std::floor(to - 0.5));
+      if (x0 <= x1) _grid.FillRow(y, x0, x1, value);
+    }
+
+    void MarkAllChanged() {
+      _version++;
+      _journal.clear();
+      _journalVersion = _version;
+    }
+
+    TraversalCostLayer<TraversalT> _traversal;
+
+    std::vector<GridSearchWorkspace> _batchWorkspaces;  // One per pool thread, for AStarBatch. Taken out while a batch runs.
+    detail::CacheMutex _batchMutex;
+
+    std::vector<CostField> _costFields;
+    detail::IndexedHeap<double> _costFieldOpen;
+    detail::CacheMutex _costFieldMutex;
+
+    DistanceField _distance;
+    uint64_t _distanceVersion = 0;
+    detail::CacheMutex _distanceMutex;
+
+    // Cells changed by Set since _journalVersion, one per version.
+    uint64_t _version = 0, _journalVersion = 0;
+    std::vector<Idx_t> _journal;
   };
 }
\ No newline at end of file
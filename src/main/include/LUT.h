@@ -8,45 +8,261 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
 #include <vector>
 
 namespace wom {
   template<typename X, typename Y>
   struct LUTPoint{
     X x = 0;
-    Y y = 0;  
+    Y y = 0;
   };
 
+  enum class LUTMode {
+    kLinearScan,    // Walk the points from the start, O(n).
+    kBinarySearch,  // Binary search for the segment, O(log n). Same results as kLinearScan.
+    kUniform,       // Resample onto evenly spaced points, O(1). Exact if the points are already evenly spaced.
+    kMonotoneCubic  // Fritsch-Carlson monotone cubic spline through the points, O(log n). Smooth slopes, no overshoot.
+  };
+
+  /**
+   * Lookup table interpolating between points, linearly or with a monotone cubic (see LUTMode).
+   * Points must be sorted by x. Estimate returns the first y below the first point and the last y
+   * past the last point, and 0 for an empty table.
+   *
+   * Slopes and cubic coefficients are precomputed per segment, so a lookup is a segment search plus
+   * a multiply-add, or a cubic in Horner form.
+   */
   template<typename X, typename Y>
   class LUT{
   public:
-    LUT(std::vector<LUTPoint<X, Y>> points) : _points(points) {}
+    using slope_t = decltype(std::declval<Y>() / std::declval<X>());
+
+    /**
+     * uniformSamples sets the number of resampled points in kUniform mode. 0 picks enough that the
+     * smallest gap between points is at least one sample wide, up to kMaxUniformSamples.
+     */
+    LUT(std::vector<LUTPoint<X, Y>> points, LUTMode mode = LUTMode::kBinarySearch, size_t uniformSamples = 0)
+      : _points(std::move(points)), _mode(mode) {
+      _slopes = Slopes(_points);
+      if (_mode == LUTMode::kUniform && _points.size() > 1)
+        Resample(uniformSamples);
+      if (_mode == LUTMode::kMonotoneCubic && _points.size() > 1)
+        FitMonotoneCubic();
+    }
 
+    static constexpr size_t kMaxUniformSamples = 4096;
 
-    Y Estimate(X x){
+    Y Estimate(X x) const {
       int tableSize = _points.size();
 
       if (tableSize == 0){  return Y{0};  }  // if no recorded data points
       if (tableSize == 1) {  return _points[0].y;  }  // if only 1 recorded data point
-      
+
       if (x < _points[0].x){  return _points[0].y;  }  // if x < allOthers
-      
-      LUTPoint<X, Y> finalPoint = _points.back();
+
+      const LUTPoint<X, Y> &finalPoint = _points.back();
       if (x > finalPoint.x){  return finalPoint.y;  }  // if x > allOthers
 
-      LUTPoint<X, Y> previousThing = _points[0];
-      for (int pointNum = 1; pointNum < tableSize; pointNum++){
-        previousThing = _points[pointNum - 1];
-        //if (_points[pointNum].x == x){  return _points[pointNum].y;  }
+      switch (_mode) {
+        case LUTMode::kLinearScan: {
+          for (int pointNum = 1; pointNum < tableSize; pointNum++){
+            if (_points[pointNum].x >= x)
+              return Interpolate(_points, _slopes, pointNum - 1, x);
+          }
+          return finalPoint.y;
+        }
+        case LUTMode::kBinarySearch: {
+          auto it = std::lower_bound(_points.begin() + 1, _points.end(), x, [](const LUTPoint<X, Y> &p, X value) { return p.x < value; });
+          return Interpolate(_points, _slopes, (it - _points.begin()) - 1, x);
+        }
+        case LUTMode::kUniform: {
+          double t = (x - _points[0].x) * _inverseStep;
+          size_t segment = std::min((size_t)t, _uniform.size() - 2);
+          return Interpolate(_uniform, _uniformSlopes, segment, x);
+        }
+        case LUTMode::kMonotoneCubic: {
+          auto it = std::lower_bound(_cubic.begin(), _cubic.end(), x, [](const CubicSegment &c, X value) { return c.x < value; });
+          const CubicSegment &c = _cubic[it == _cubic.begin() ? 0 : (it - _cubic.begin()) - 1];
+          double s = (x - c.x) * c.inverseWidth;
+          return c.c0 + (c.c1 + (c.c2 + c.c3 * s) * s) * s;
+        }
+      }
+      return finalPoint.y;
+    }
+
+    LUTMode GetMode() const { return _mode; }
+    const std::vector<LUTPoint<X, Y>> &GetPoints() const { return _points; }
+
+  private:
+    static std::vector<slope_t> Slopes(const std::vector<LUTPoint<X, Y>> &points) {
+      std::vector<slope_t> slopes;
+      for (size_t i = 1; i < points.size(); i++) {
+        // Repeated x values make a step, which has no slope of its own.
+        X dx = points[i].x - points[i - 1].x;
+        slopes.push_back(dx > X{0} ? (points[i].y - points[i - 1].y) / dx : slope_t{0});
+      }
+      return slopes;
+    }
+
+    static Y Interpolate(const std::vector<LUTPoint<X, Y>> &points, const std::vector<slope_t> &slopes, size_t segment, X x) {
+      return points[segment].y + slopes[segment] * (x - points[segment].x); // y = mx+c
+    }
 
-        if (_points[pointNum].x >= x){
-          double m = (_points[pointNum].y - previousThing.y) / (_points[pointNum].x - previousThing.x);
-          return m * (x - previousThing.x) + previousThing.y; // y = mx+c
+    void Resample(size_t samples) {
+      X span = _points.back().x - _points[0].x;
+      if (samples == 0) {
+        X minGap = span;
+        for (size_t i = 1; i < _points.size(); i++)
+          if (_points[i].x - _points[i - 1].x > X{0}) minGap = std::min(minGap, _points[i].x - _points[i - 1].x);
+        samples = minGap > X{0} ? (size_t)std::ceil((double)(span / minGap)) + 1 : 2;
+      }
+      samples = std::clamp(samples, (size_t)2, kMaxUniformSamples);
+
+      X step = span / (double)(samples - 1);
+      _inverseStep = step > X{0} ? 1.0 / step : decltype(1.0 / step){0};
+      _uniform.clear();
+      size_t segment = 0;
+      for (size_t i = 0; i < samples; i++) {
+        X x = i + 1 == samples ? _points.back().x : _points[0].x + step * (double)i;
+        while (segment + 2 < _points.size() && _points[segment + 1].x < x) segment++;
+        _uniform.push_back({ x, Interpolate(_points, _slopes, segment, x) });
+      }
+      _uniformSlopes = Slopes(_uniform);
+    }
+
+    /**
+     * Fit a cubic Hermite segment between each pair of points, with Fritsch-Carlson tangents: the
+     * average of the neighbouring slopes, 0 at local extrema, and scaled back where they would
+     * overshoot. Each segment is stored with its start x as y = c0 + c1 s + c2 s^2 + c3 s^3, for s
+     * from 0 to 1 across the segment.
+     */
+    void FitMonotoneCubic() {
+      size_t n = _points.size();
+      std::vector<slope_t> m(n);
+      m[0] = _slopes[0];
+      m[n - 1] = _slopes[n - 2];
+      auto step = [this](size_t k) { return !(_points[k + 1].x > _points[k].x); };
+      for (size_t k = 1; k + 1 < n; k++) {
+        slope_t a = _slopes[k - 1], b = _slopes[k];
+        // A repeated x is a step, so each side of it is treated as an end.
+        if (step(k - 1)) m[k] = b;
+        else if (step(k)) m[k] = a;
+        else m[k] = (a > slope_t{0}) == (b > slope_t{0}) && a != slope_t{0} && b != slope_t{0} ? (a + b) / 2.0 : slope_t{0};
+      }
+      for (size_t k = 0; k + 1 < n; k++) {
+        if (step(k)) continue;
+        if (_slopes[k] == slope_t{0}) {
+          m[k] = m[k + 1] = slope_t{0};
+          continue;
         }
+        double alpha = m[k] / _slopes[k], beta = m[k + 1] / _slopes[k];
+        double r = alpha * alpha + beta * beta;
+        if (r > 9) {
+          double tau = 3 / std::sqrt(r);
+          m[k] = tau * alpha * _slopes[k];
+          m[k + 1] = tau * beta * _slopes[k];
+        }
+      }
+
+      _cubic.clear();
+      for (size_t k = 0; k + 1 < n; k++) {
+        X h = _points[k + 1].x - _points[k].x;
+        Y y0 = _points[k].y, y1 = _points[k + 1].y;
+        Y t0 = m[k] * h, t1 = m[k + 1] * h;
+        _cubic.push_back(CubicSegment{
+          _points[k].x, h > X{0} ? 1.0 / h : decltype(1.0 / h){0},
+          y0, t0, 3.0 * (y1 - y0) - 2.0 * t0 - t1, 2.0 * (y0 - y1) + t0 + t1
+        });
       }
+    }
+
+    struct CubicSegment {
+      X x;
+      decltype(1.0 / std::declval<X>()) inverseWidth;
+      Y c0, c1, c2, c3;
     };
 
-  private:
     std::vector<LUTPoint<X, Y>> _points;
+    std::vector<slope_t> _slopes;
+    LUTMode _mode;
+
+    std::vector<CubicSegment> _cubic;
+
+    std::vector<LUTPoint<X, Y>> _uniform;
+    std::vector<slope_t> _uniformSlopes;
+    decltype(1.0 / std::declval<X>()) _inverseStep{0};
   };
+
+  /**
+   * Fixed-size LUT for tables known at build time, with the same results as LUT. Declared
+   * constexpr, the slopes are computed and the points checked to be sorted during compilation, and
+   * Estimate is a few inlined compares and a multiply-add.
+   *
+   * Only a table built at compile time gets the sort check then: a StaticLUT declared without
+   * constexpr throws std::invalid_argument at runtime instead. Build tables with MakeStaticLUT
+   * (below) to always reject unsorted points during compilation.
+   *
+   *   constexpr StaticLUT<units::meter_t, units::radian_t, 3> kArmTable{{{ {1_m, 0.2_rad}, {2_m, 0.5_rad}, {4_m, 0.7_rad} }}};
+   */
+  template<typename X, typename Y, size_t N>
+  class StaticLUT {
+   public:
+    static_assert(N > 0, "StaticLUT needs at least one point");
+    using slope_t = decltype(std::declval<Y>() / std::declval<X>());
+
+    constexpr StaticLUT(const std::array<LUTPoint<X, Y>, N> &points) : _points(points) {
+      if (!IsSorted(points))
+        throw std::invalid_argument("StaticLUT points must be sorted by x");
+      for (size_t i = 1; i < N; i++) {
+        X dx = points[i].x - points[i - 1].x;
+        _slopes[i - 1] = dx > X{0} ? (points[i].y - points[i - 1].y) / dx : slope_t{0};
+      }
+    }
+
+    static constexpr bool IsSorted(const std::array<LUTPoint<X, Y>, N> &points) {
+      for (size_t i = 1; i < N; i++)
+        if (points[i].x < points[i - 1].x) return false;
+      return true;
+    }
+
+    constexpr Y Estimate(X x) const {
+      if constexpr (N == 1) {
+        return _points[0].y;
+      } else {
+        if (!(x > _points[0].x)) return _points[0].y;
+        if (x > _points[N - 1].x) return _points[N - 1].y;
+
+        // points[lo].x < x <= points[hi].x
+        size_t lo = 0, hi = N - 1;
+        while (hi - lo > 1) {
+          size_t mid = (lo + hi) / 2;
+          if (_points[mid].x < x) lo = mid;
+          else hi = mid;
+        }
+        return _points[lo].y + _slopes[lo] * (x - _points[lo].x);
+      }
+    }
+
+    constexpr const std::array<LUTPoint<X, Y>, N> &GetPoints() const { return _points; }
+
+   private:
+    std::array<LUTPoint<X, Y>, N> _points;
+    std::array<slope_t, N - 1> _slopes{};
+  };
+
+  /**
+   * Build a StaticLUT during compilation, wherever it is declared. Unsorted points fail to compile.
+   *
+   *   auto armTable = MakeStaticLUT<units::meter_t, units::radian_t>({ {1_m, 0.2_rad}, {2_m, 0.5_rad}, {4_m, 0.7_rad} });
+   */
+  template<typename X, typename Y, size_t N>
+  consteval StaticLUT<X, Y, N> MakeStaticLUT(const LUTPoint<X, Y> (&points)[N]) {
+    return StaticLUT<X, Y, N>{ std::to_array(points) };
+  }
 }
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace wom {
+  enum class LUT2DInterpolation {
+    kBilinear,
+    kBicubic    // Separable cubic Hermite with Catmull-Rom tangents, C1 across cells.
+  };
+
+  /**
+   * One axis of a LUT2D: sorted knots, with each lookup reduced to the cell it falls in and up to
+   * four knot weights. Evenly spaced axes find the cell with one multiply, others binary search.
+   */
+  template<typename T>
+  class LUTAxis {
+   public:
+    struct Weights {
+      std::array<size_t, 4> idx;
+      std::array<double, 4> w;
+    };
+
+    LUTAxis(std::vector<T> knots) : _knots(std::move(knots)) {
+      if (_knots.size() < 2)
+        throw std::invalid_argument("LUT2D axes need at least two knots");
+      for (size_t i = 1; i < _knots.size(); i++)
+        if (!(_knots[i] > _knots[i - 1])) throw std::invalid_argument("LUT2D axis knots must be strictly increasing");
+
+      size_t n = _knots.size();
+      T step = (_knots.back() - _knots.front()) / (double)(n - 1);
+      _uniform = true;
+      for (size_t i = 1; i < n; i++) {
+        double spacing = (_knots[i] - _knots[i - 1]) / step;
+        if (std::abs(spacing - 1) > 1e-9) _uniform = false;
+      }
+      _inverseStep = 1.0 / step;
+
+      // Catmull-Rom tangents at each end of each cell, scaled to the cell width. Tangents at the ends
+      // of the axis are one-sided.
+      for (size_t i = 0; i + 1 < n; i++) {
+        T h = _knots[i + 1] - _knots[i];
+        _alpha.push_back(i == 0 ? 1.0 : (double)(h / (_knots[i + 1] - _knots[i - 1])));
+        _beta.push_back(i + 2 == n ? 1.0 : (double)(h / (_knots[i + 2] - _knots[i])));
+      }
+    }
+
+    size_t Size() const { return _knots.size(); }
+    bool IsUniform() const { return _uniform; }
+    const std::vector<T> &GetKnots() const { return _knots; }
+
+    // Find the cell containing v, clamped to the axis, and the fraction t of the way across it.
+    size_t Locate(T v, double &t) const {
+      size_t n = _knots.size();
+      if (!(v > _knots.front())) { t = 0; return 0; }
+      if (!(v < _knots.back())) { t = 1; return n - 2; }
+
+      size_t i;
+      if (_uniform) {
+        double u = (v - _knots.front()) * _inverseStep;
+        i = std::min((size_t)u, n - 2);
+      } else {
+        i = (std::upper_bound(_knots.begin(), _knots.end(), v) - _knots.begin()) - 1;
+      }
+      t = std::clamp((double)((v - _knots[i]) / (_knots[i + 1] - _knots[i])), 0.0, 1.0);
+      return i;
+    }
+
+    Weights Linear(T v) const {
+      double t;
+      size_t i = Locate(v, t);
+      return Weights{ { i, i + 1, i, i }, { 1 - t, t, 0, 0 } };
+    }
+
+    Weights Cubic(T v) const {
+      double t;
+      size_t i = Locate(v, t), n = _knots.size();
+      double t2 = t * t, t3 = t2 * t;
+      double h00 = 2 * t3 - 3 * t2 + 1, h10 = t3 - 2 * t2 + t, h01 = -2 * t3 + 3 * t2, h11 = t3 - t2;
+      double a = _alpha[i], b = _beta[i];
+
+      // p(t) = h00 z[i] + h10 a (z[i+1] - z[i-1]) + h01 z[i+1] + h11 b (z[i+2] - z[i]), with the
+      // outer knots clamped to the axis.
+      return Weights{
+        { i == 0 ? 0 : i - 1, i, i + 1, std::min(i + 2, n - 1) },
+        { -h10 * a, h00 - h11 * b, h01 + h10 * a, h11 * b }
+      };
+    }
+
+   private:
+    std::vector<T> _knots;
+    std::vector<double> _alpha, _beta;
+    bool _uniform;
+    decltype(1.0 / std::declval<T>()) _inverseStep;
+  };
+
+  /**
+   * Two-dimensional lookup table on a rectilinear grid, e.g. shooter speed against (distance,
+   * approach angle). values are row-major with x varying fastest: z(xs[i], ys[j]) is
+   * values[j * xs.size() + i]. Lookups outside the grid are clamped to its edge, as with LUT.
+   */
+  template<typename X, typename Y, typename Z>
+  class LUT2D {
+   public:
+    LUT2D(std::vector<X> xs, std::vector<Y> ys, std::vector<Z> values, LUT2DInterpolation interpolation = LUT2DInterpolation::kBilinear)
+      : _x(std::move(xs)), _y(std::move(ys)), _values(std::move(values)), _interpolation(interpolation) {
+      if (_values.size() != _x.Size() * _y.Size())
+        throw std::invalid_argument("LUT2D needs one value per (x, y) knot");
+    }
+
+    Z Estimate(X x, Y y) const {
+      if (_interpolation == LUT2DInterpolation::kBicubic)
+        return Combine<4>(_x.Cubic(x), _y.Cubic(y));
+      return Combine<2>(_x.Linear(x), _y.Linear(y));
+    }
+
+    /**
+     * Estimate at each (xs[k], ys[k]) into out[k], with the interpolation choice hoisted out of the loop.
+     */
+    void Estimate(std::span<const X> xs, std::span<const Y> ys, std::span<Z> out) const {
+      if (xs.size() != ys.size() || xs.size() != out.size())
+        throw std::invalid_argument("LUT2D batch spans must be the same length");
+
+      if (_interpolation == LUT2DInterpolation::kBicubic) {
+        for (size_t k = 0; k < xs.size(); k++) out[k] = Combine<4>(_x.Cubic(xs[k]), _y.Cubic(ys[k]));
+      } else {
+        for (size_t k = 0; k < xs.size(); k++) out[k] = Combine<2>(_x.Linear(xs[k]), _y.Linear(ys[k]));
+      }
+    }
+
+    const LUTAxis<X> &GetXAxis() const { return _x; }
+    const LUTAxis<Y> &GetYAxis() const { return _y; }
+    LUT2DInterpolation GetInterpolation() const { return _interpolation; }
+
+   private:
+    template<size_t K>
+    Z Combine(const typename LUTAxis<X>::Weights &wx, const typename LUTAxis<Y>::Weights &wy) const {
+      Z result{0};
+      size_t cols = _x.Size();
+      for (size_t b = 0; b < K; b++) {
+        const Z *row = &_values[wy.idx[b] * cols];
+        Z along{0};
+        for (size_t a = 0; a < K; a++) along += row[wx.idx[a]] * wx.w[a];
+        result += along * wy.w[b];
+      }
+      return result;
+    }
+
+    LUTAxis<X> _x;
+    LUTAxis<Y> _y;
+    std::vector<Z> _values;
+    LUT2DInterpolation _interpolation;
+  };
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "LUT.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace wom {
+  /**
+   * A LUT that can be retuned while it is in use, e.g. from an NT listener during practice while
+   * the shooter reads it every tick.
+   *
+   * Each change builds a new immutable LUT and publishes it with a single pointer swap. Readers
+   * take no lock and do not allocate: they mark themselves active on one of two counters, read the
+   * current table and unmark. A writer frees the old table only once both counters have drained
+   * past the swap (a two-phase grace period, as in userspace RCU). Writers are serialised against
+   * each other and may briefly wait for readers. Readers never wait.
+   *
+   * Don't call a writer from inside Read on the same thread, as it would wait on itself.
+   */
+  template<typename X, typename Y>
+  class LiveLUT {
+   public:
+    using lut_t = LUT<X, Y>;
+
+    LiveLUT(std::vector<LUTPoint<X, Y>> points = {}, LUTMode mode = LUTMode::kBinarySearch)
+      : _points(std::move(points)), _mode(mode) {
+      Sort(_points);
+      _current.store(new lut_t(_points, _mode));
+    }
+
+    ~LiveLUT() { delete _current.load(); }
+
+    LiveLUT(const LiveLUT &) = delete;
+    LiveLUT &operator=(const LiveLUT &) = delete;
+
+    Y Estimate(X x) const {
+      return Read([x](const lut_t &lut) { return lut.Estimate(x); });
+    }
+
+    /**
+     * Call f with the current table, for several lookups against the same snapshot.
+     */
+    template<typename F>
+    auto Read(F &&f) const {
+      ReadGuard guard{ *this };
+      return f(*_current.load(std::memory_order_seq_cst));
+    }
+
+    // Set y at x, replacing any point already at x.
+    void Set(X x, Y y) {
+      Update([&](std::vector<LUTPoint<X, Y>> &points) {
+        auto it = std::lower_bound(points.begin(), points.end(), x, [](const LUTPoint<X, Y> &p, X value) { return p.x < value; });
+        if (it != points.end() && it->x == x) it->y = y;
+        else points.insert(it, LUTPoint<X, Y>{ x, y });
+      });
+    }
+
+    // Remove the point at x, if there is one.
+    void Remove(X x) {
+      Update([&](std::vector<LUTPoint<X, Y>> &points) {
+        points.erase(std::remove_if(points.begin(), points.end(), [x](const LUTPoint<X, Y> &p) { return p.x == x; }), points.end());
+      });
+    }
+
+    void SetPoints(std::vector<LUTPoint<X, Y>> points) {
+      Update([&](std::vector<LUTPoint<X, Y>> &current) {
+        current = std::move(points);
+        Sort(current);
+      });
+    }
+
+    std::vector<LUTPoint<X, Y>> GetPoints() const {
+      std::lock_guard<std::mutex> lock{ _writeMutex };
+      return _points;
+    }
+
+    // Incremented by every change.
+    uint64_t GetVersion() const { return _version.load(); }
+
+    /**
+     * Call hook on the writing thread with each replaced table just before it is freed, i.e. once
+     * no reader can still be using it. For tests and diagnostics.
+     */
+    void SetRetireHook(std::function<void(const lut_t &)> hook) {
+      std::lock_guard<std::mutex> lock{ _writeMutex };
+      _retireHook = std::move(hook);
+    }
+
+   private:
+    struct ReadGuard {
+      const LiveLUT &lut;
+      unsigned int epoch;
+
+      ReadGuard(const LiveLUT &l) : lut(l), epoch(l._epoch.load() & 1) { lut._readers[epoch].fetch_add(1); }
+      ~ReadGuard() { lut._readers[epoch].fetch_sub(1, std::memory_order_release); }
+    };
+
+    static void Sort(std::vector<LUTPoint<X, Y>> &points) {
+      std::stable_sort(points.begin(), points.end(), [](const LUTPoint<X, Y> &a, const LUTPoint<X, Y> &b) { return a.x < b.x; });
+    }
+
+    template<typename F>
+    void Update(F &&f) {
+      std::lock_guard<std::mutex> lock{ _writeMutex };
+      f(_points);
+      const lut_t *old = _current.exchange(new lut_t(_points, _mode));
+      _version++;
+
+      // Any reader still holding the old table registered on one of the two counters before the
+      // swap. Flip the epoch and drain each counter in turn, then nobody can be using it.
+      for (int phase = 0; phase < 2; phase++) {
+        unsigned int drained = _epoch.fetch_add(1) & 1;
+        while (_readers[drained].load(std::memory_order_acquire) != 0)
+          std::this_thread::yield();
+      }
+      if (_retireHook) _retireHook(*old);
+      delete old;
+    }
+
+    mutable std::mutex _writeMutex;
+    std::vector<LUTPoint<X, Y>> _points;
+    LUTMode _mode;
+    std::function<void(const lut_t &)> _retireHook;
+
+    std::atomic<const lut_t *> _current{ nullptr };
+    mutable std::atomic<unsigned int> _epoch{ 0 };
+    mutable std::atomic<unsigned int> _readers[2]{ {0}, {0} };
+    std::atomic<uint64_t> _version{ 0 };
+  };
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+namespace wom {
+  /**
+   * Moving average of the last N samples. Gives the same output as
+   * frc::LinearFilter<T>::MovingAverage(N), with the history starting at zero, but each sample
+   * costs O(1): a ring buffer and a running sum instead of an N-tap multiply-accumulate. The window
+   * is a template parameter, so the filter lives inline with no heap storage.
+   */
+  template<typename T, size_t N>
+  class MovingAverage {
+   public:
+    static_assert(N > 0, "MovingAverage needs a window of at least one sample");
+
+    MovingAverage() { Reset(); }
+
+    T Calculate(T input) {
+      _sum += input - _history[_next];
+      _history[_next] = input;
+      if (++_next == N) {
+        _next = 0;
+        // Re-add the window once per lap so rounding error in the running sum cannot build up.
+        _sum = T{0};
+        for (const T &v : _history) _sum += v;
+      }
+      return Get();
+    }
+
+    T Get() const {
+      return _sum / (double)N;
+    }
+
+    void Reset() {
+      _history.fill(T{0});
+      _sum = T{0};
+      _next = 0;
+    }
+
+    static constexpr size_t Window() { return N; }
+
+   private:
+    std::array<T, N> _history;
+    T _sum;
+    size_t _next;
+  };
+}
@@ -23,6 +23,14 @@ namespace wom {
         }));
       }
     
+    // Bind to an entry without publishing a value, e.g. one that already holds the current value.
+    NTBound(std::shared_ptr<nt::NetworkTable> table, std::string name, std::function<void(const nt::Value &)> onUpdateFn)
+      : _table(table), _entry(table->GetEntry(name)), _onUpdate(onUpdateFn), _name(name) {
+        _listener = table->AddListener(name, nt::EventFlags::kValueAll, ([this](nt::NetworkTable *table, std::string_view key, const nt::Event &event) {
+          this->_onUpdate(event.GetValueEventData()->value);
+        }));
+      }
+
     NTBound(const NTBound &other) 
       : _table(other._table), _entry(other._entry), _onUpdate(other._onUpdate), _name(other._name) {
       
@@ -1,17 +1,31 @@
 #pragma once
 
+#include "MovingAverage.h"
 #include "NTUtil.h"
+#include "SeqLock.h"
 
 #include <units/base.h>
 #include <units/time.h>
 
-#include <frc/filter/LinearFilter.h>
+#include <networktables/BooleanTopic.h>
+#include <networktables/DoubleTopic.h>
 #include <networktables/NetworkTableInstance.h>
 
+#include <algorithm>
+#include <memory>
 #include <optional>
 #include <vector>
 
 namespace wom {
+  /**
+   * How much a PIDController publishes to NT from Calculate.
+   */
+  enum class PIDTelemetry {
+    kOff,        // Nothing.
+    kDecimated,  // Every Nth call, 10 unless set by PIDController::SetTelemetry.
+    kFull        // Every call.
+  };
+
   template<typename IN, typename OUT>
   struct PIDConfig {
     using in_t = units::unit_t<IN>;
@@ -23,34 +37,85 @@ namespace wom {
     using error_t = units::unit_t<IN>;
     using deriv_t = units::unit_t<units::compound_unit<IN, units::inverse<units::second>>>;
 
+    /**
+     * One consistent set of gains, as PIDController reads them at the start of each Calculate.
+     */
+    struct Gains {
+      kp_t kp;
+      ki_t ki;
+      kd_t kd;
+      error_t stableThresh;
+      deriv_t stableDerivThresh;
+      in_t izone;
+    };
+
+    // The gains are only given here. Afterwards, read and change them with GetGains and SetGains
+    // (or over NT), which are safe across threads.
     PIDConfig(std::string path, kp_t kp = kp_t{0}, ki_t ki = ki_t{0}, kd_t kd = kd_t{0}, error_t stableThresh = error_t{-1}, deriv_t stableDerivThresh = deriv_t{-1}, in_t izone = in_t{-1})
-      : path(path), kp(kp), ki(ki), kd(kd), stableThresh(stableThresh), stableDerivThresh(stableDerivThresh), izone(izone) {
+      : path(path), _initial{ kp, ki, kd, stableThresh, stableDerivThresh, izone } {
       RegisterNT();
     }
 
+    // A copy gets its own gains, seeded from other's current gains (including any tuning) and bound
+    // to the same NT path. The path already holds those gains, so nothing is published.
+    PIDConfig(const PIDConfig &other)
+      : path(other.path), _initial(other._initial) {
+      BindNT(other.GetGains(), false);
+    }
+
+    PIDConfig &operator=(const PIDConfig &other) {
+      if (this != &other) {
+        path = other.path;
+        _initial = other._initial;
+        BindNT(other.GetGains(), false);
+      }
+      return *this;
+    }
+
     std::string path;
 
-    kp_t kp;
-    ki_t ki{0};
-    kd_t kd{0};
+    Gains GetGains() const {
+      return _gains->Load();
+    }
 
-    error_t stableThresh{-1};
-    deriv_t stableDerivThresh{-1};
+    void SetGains(const Gains &gains) {
+      _gains->Store(gains);
+    }
 
-    in_t izone{-1};
+    // Reset the gains to those given at construction and publish them to NT.
+    void RegisterNT() {
+      BindNT(_initial, true);
+    }
 
    private:
+    Gains _initial;
+    // Written by the NT listener thread and read by Calculate, so it is published as a whole.
+    std::shared_ptr<SeqLock<Gains>> _gains;
     std::vector<std::shared_ptr<NTBound>> _nt_bindings;
 
-   public:
-    void RegisterNT() {
+    template<typename T>
+    void Bind(std::shared_ptr<nt::NetworkTable> table, std::string name, T Gains::*gain, bool publish) {
+      auto gains = _gains;
+      auto onUpdate = [gains, gain](const nt::Value &v) {
+        gains->Update([&](Gains &g) { g.*gain = T{ v.GetDouble() }; });
+      };
+      if (publish)
+        _nt_bindings.emplace_back(std::make_shared<NTBound>(table, name, nt::Value::MakeDouble((gains->Load().*gain).value()), onUpdate));
+      else
+        _nt_bindings.emplace_back(std::make_shared<NTBound>(table, name, onUpdate));
+    }
+
+    void BindNT(const Gains &initial, bool publish) {
+      _nt_bindings.clear();
+      _gains = std::make_shared<SeqLock<Gains>>(initial);
+
       auto table = nt::NetworkTableInstance::GetDefault().GetTable(path);
-      _nt_bindings.emplace_back(std::make_shared<NTBoundUnit<typename kp_t::unit_type>>(table, "kP", kp));
-      _nt_bindings.emplace_back(std::make_shared<NTBoundUnit<typename ki_t::unit_type>>(table, "kI", ki));
-      _nt_bindings.emplace_back(std::make_shared<NTBoundUnit<typename kd_t::unit_type>>(table, "kD", kd));
-      _nt_bindings.emplace_back(std::make_shared<NTBoundUnit<typename error_t::unit_type>>(table, "stableThresh", stableThresh));
-      _nt_bindings.emplace_back(std::make_shared<NTBoundUnit<typename deriv_t::unit_type>>(table, "stableThreshVelocity", stableDerivThresh));
-      _nt_bindings.emplace_back(std::make_shared<NTBoundUnit<IN>>(table, "izone", izone));
+      Bind(table, "kP", &Gains::kp, publish);
+      Bind(table, "kI", &Gains::ki, publish);
+      Bind(table, "kD", &Gains::kd, publish);
+      Bind(table, "stableThresh", &Gains::stableThresh, publish);
+      Bind(table, "stableThreshVelocity", &Gains::stableDerivThresh, publish);
+      Bind(table, "izone", &Gains::izone, publish);
     }
   };
 
@@ -64,11 +129,29 @@ namespace wom {
 
     config_t config;
 
-    PIDController(std::string path, config_t initialGains, in_t setpoint = in_t{0}) 
+    static constexpr int kDefaultDecimation = 10;
+
+    // With telemetry kDecimated, every kDefaultDecimation-th call publishes; see SetTelemetry.
+    PIDController(std::string path, config_t initialGains, in_t setpoint = in_t{0}, PIDTelemetry telemetry = PIDTelemetry::kFull)
       : config(initialGains), _setpoint(setpoint),
-        _posFilter(frc::LinearFilter<typename config_t::error_t>::MovingAverage(20)),
-        _velFilter(frc::LinearFilter<typename config_t::deriv_t>::MovingAverage(20)),
-        _table(nt::NetworkTableInstance::GetDefault().GetTable(path)) { }
+        _table(nt::NetworkTableInstance::GetDefault().GetTable(path)),
+        _publishers(std::make_shared<Publishers>(*_table)),
+        _telemetry(telemetry) { }
+
+    /**
+     * Set how much Calculate publishes to NT. The publishers are resolved once at construction, so
+     * publishing costs no table lookups, but with many controllers the dashboard traffic adds up.
+     * With kDecimated, every decimation-th call publishes.
+     */
+    void SetTelemetry(PIDTelemetry level, int decimation = kDefaultDecimation) {
+      _telemetry = level;
+      _decimation = std::max(decimation, 1);
+      _telemetryTicks = 0;
+    }
+
+    PIDTelemetry GetTelemetry() const {
+      return _telemetry;
+    }
 
     void SetSetpoint(in_t setpoint) {
       if (std::abs(setpoint.value() - _setpoint.value()) > std::abs(0.1 * _setpoint.value())) {
@@ -94,9 +177,17 @@ namespace wom {
     }
 
     out_t Calculate(in_t pv, units::second_t dt, out_t feedforward = out_t{0}) {
+      // One snapshot per call, so a retune from NT never lands mid-calculation.
+      return Calculate(pv, dt, config.GetGains(), feedforward);
+    }
+
+    /**
+     * Calculate with the given gains in place of the config's, e.g. from a gain schedule.
+     */
+    out_t Calculate(in_t pv, units::second_t dt, const typename config_t::Gains &gains, out_t feedforward = out_t{0}) {
       auto error = do_wrap(_setpoint - pv);
       _integralSum += error * dt;
-      if (config.izone.value() > 0 && (error > config.izone || error < -config.izone))
+      if (gains.izone.value() > 0 && (error > gains.izone || error < -gains.izone))
         _integralSum = sum_t{0};
       
       typename config_t::deriv_t deriv{0};
@@ -107,16 +198,18 @@ namespace wom {
       _stablePos = _posFilter.Calculate(error);
       _stableVel = _velFilter.Calculate(deriv);
 
-      auto out = config.kp * error + config.ki * _integralSum + config.kd * deriv + feedforward;
+      auto out = gains.kp * error + gains.ki * _integralSum + gains.kd * deriv + feedforward;
       // std::cout << "Out value" << out.value() << std::endl;
 
-      _table->GetEntry("pv").SetDouble(pv.value());
-      _table->GetEntry("dt").SetDouble(dt.value());
-      _table->GetEntry("setpoint").SetDouble(_setpoint.value());
-      _table->GetEntry("error").SetDouble(error.value());
-      _table->GetEntry("integralSum").SetDouble(_integralSum.value());
-      _table->GetEntry("stable").SetBoolean(IsStable());
-      _table->GetEntry("demand").SetDouble(out.value());
+      if (_telemetry == PIDTelemetry::kFull || (_telemetry == PIDTelemetry::kDecimated && _telemetryTicks++ % _decimation == 0)) {
+        _publishers->pv.Set(pv.value());
+        _publishers->dt.Set(dt.value());
+        _publishers->setpoint.Set(_setpoint.value());
+        _publishers->error.Set(error.value());
+        _publishers->integralSum.Set(_integralSum.value());
+        _publishers->stable.Set(IsStable(gains));
+        _publishers->demand.Set(out.value());
+      }
 
       _last_pv = pv;
       _last_error = error;
@@ -125,18 +218,32 @@ namespace wom {
     }
 
     bool IsStable(std::optional<typename config_t::error_t> stableThreshOverride = {}, std::optional<typename config_t::deriv_t> velocityThreshOverride = {}) const {
-      auto stableThresh = config.stableThresh;
-      auto stableDerivThresh = config.stableDerivThresh;
+      return IsStable(config.GetGains(), stableThreshOverride, velocityThreshOverride);
+    }
 
-      if (stableThreshOverride.has_value()) stableThresh = stableThreshOverride.value();
-      if (velocityThreshOverride.has_value()) stableDerivThresh = velocityThreshOverride.value();
+   private:
+    // Stability against the given gains' thresholds, so Calculate with scheduled gains reports
+    // against the gains it ran with.
+    bool IsStable(const typename config_t::Gains &gains, std::optional<typename config_t::error_t> stableThreshOverride = {}, std::optional<typename config_t::deriv_t> velocityThreshOverride = {}) const {
+      auto stableThresh = stableThreshOverride.value_or(gains.stableThresh);
+      auto stableDerivThresh = velocityThreshOverride.value_or(gains.stableDerivThresh);
 
-      return _iterations > 20
+      return _iterations > (int)kStabilityWindow
         && std::abs(_stablePos.value()) <= std::abs(stableThresh.value())
         && (stableDerivThresh.value() < 0 || std::abs(_stableVel.value()) <= stableDerivThresh.value());
     }
 
-   private:
+    struct Publishers {
+      Publishers(nt::NetworkTable &table)
+        : pv(table.GetDoubleTopic("pv").Publish()), dt(table.GetDoubleTopic("dt").Publish()),
+          setpoint(table.GetDoubleTopic("setpoint").Publish()), error(table.GetDoubleTopic("error").Publish()),
+          integralSum(table.GetDoubleTopic("integralSum").Publish()), demand(table.GetDoubleTopic("demand").Publish()),
+          stable(table.GetBooleanTopic("stable").Publish()) {}
+
+      nt::DoublePublisher pv, dt, setpoint, error, integralSum, demand;
+      nt::BooleanPublisher stable;
+    };
+
     in_t do_wrap(in_t val) {
       if (_wrap_range.has_value()) {
         double wr = _wrap_range.value().value();
@@ -160,12 +267,20 @@ namespace wom {
     
     int _iterations = 0;
 
-    frc::LinearFilter<typename config_t::error_t> _posFilter;
-    frc::LinearFilter<typename config_t::deriv_t> _velFilter;
+    // Averaged over the last kStabilityWindow calls to Calculate for IsStable.
+    static constexpr size_t kStabilityWindow = 20;
+    MovingAverage<typename config_t::error_t, kStabilityWindow> _posFilter;
+    MovingAverage<typename config_t::deriv_t, kStabilityWindow> _velFilter;
 
     typename config_t::error_t _stablePos;
     typename config_t::deriv_t _stableVel;
 
     std::shared_ptr<nt::NetworkTable> _table;
+    // Shared so controllers stay copyable; copies publish to the same topics, as they did through the table.
+    std::shared_ptr<Publishers> _publishers;
+
+    PIDTelemetry _telemetry;
+    int _decimation = kDefaultDecimation;
+    unsigned int _telemetryTicks = 0;
   };
 }
\ No newline at end of file
@@ -0,0 +1,208 @@
+#pragma once
+
+#include "PID.h"
+
+#include <units/time.h>
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <optional>
+
+namespace wom {
+  template<size_t N>
+  class PIDBank;
+
+  /**
+   * A unit-typed view of one lane of a PIDBank, with the same interface as PIDController (bar
+   * Calculate, which runs for the whole bank at once).
+   */
+  template<size_t N, typename IN, typename OUT>
+  class PIDBankLane {
+   public:
+    using config_t = PIDConfig<IN, OUT>;
+    using in_t = units::unit_t<IN>;
+    using out_t = units::unit_t<OUT>;
+
+    PIDBankLane(PIDBank<N> &bank, size_t lane) : _bank(bank), _lane(lane) {}
+
+    void Configure(const config_t &config) {
+      auto gains = config.GetGains();
+      _bank.Configure(_lane, gains.kp.value(), gains.ki.value(), gains.kd.value(), gains.izone.value(), gains.stableThresh.value(), gains.stableDerivThresh.value());
+    }
+    void SetWrap(std::optional<in_t> range) { _bank.SetWrap(_lane, range.has_value() ? range.value().value() : 0); }
+
+    void SetSetpoint(in_t setpoint) { _bank.SetSetpoint(_lane, setpoint.value()); }
+    in_t GetSetpoint() const { return in_t{_bank.GetSetpoint(_lane)}; }
+    in_t GetError() const { return in_t{_bank.GetError(_lane)}; }
+
+    // Inputs to the next PIDBank::Calculate.
+    void SetInput(in_t pv, out_t feedforward = out_t{0}) { _bank.SetInput(_lane, pv.value(), feedforward.value()); }
+    void SetEnabled(bool enabled) { _bank.SetEnabled(_lane, enabled); }
+
+    out_t GetOutput() const { return out_t{_bank.GetOutput(_lane)}; }
+
+    bool IsStable(std::optional<typename config_t::error_t> stableThreshOverride = {}, std::optional<typename config_t::deriv_t> velocityThreshOverride = {}) const {
+      return _bank.IsStable(_lane,
+        stableThreshOverride.has_value() ? std::optional<double>{stableThreshOverride.value().value()} : std::nullopt,
+        velocityThreshOverride.has_value() ? std::optional<double>{velocityThreshOverride.value().value()} : std::nullopt);
+    }
+
+    void Reset() { _bank.Reset(_lane); }
+
+   private:
+    PIDBank<N> &_bank;
+    size_t _lane;
+  };
+
+  /**
+   * N PID controllers stored as parallel arrays and evaluated together, e.g. the angle and velocity
+   * loops of all four swerve modules. Each lane behaves as a PIDController: the same wrap, izone,
+   * setpoint-change and stability rules. The lanes may have different units; use GetLane for a
+   * typed view of one. Values are stored in each lane's own units.
+   *
+   * A bank publishes nothing to NT, unlike PIDController.
+   */
+  template<size_t N>
+  class PIDBank {
+   public:
+    template<typename IN, typename OUT>
+    PIDBankLane<N, IN, OUT> GetLane(size_t lane) {
+      return PIDBankLane<N, IN, OUT>{ *this, lane };
+    }
+
+    void Configure(size_t lane, double kp, double ki, double kd, double izone, double stableThresh, double stableDerivThresh) {
+      _kp[lane] = kp;
+      _ki[lane] = ki;
+      _kd[lane] = kd;
+      _izone[lane] = izone;
+      _stableThresh[lane] = stableThresh;
+      _stableDerivThresh[lane] = stableDerivThresh;
+    }
+
+    // Wrap the error into (-range/2, range/2], or 0 for no wrapping.
+    void SetWrap(size_t lane, double range) {
+      _wrap[lane] = range;
+    }
+
+    void SetSetpoint(size_t lane, double setpoint) {
+      if (std::abs(setpoint - _setpoint[lane]) > std::abs(0.1 * _setpoint[lane]))
+        _iterations[lane] = 0;
+      _setpoint[lane] = setpoint;
+    }
+
+    double GetSetpoint(size_t lane) const { return _setpoint[lane]; }
+    double GetError(size_t lane) const { return _lastError[lane]; }
+
+    void SetInput(size_t lane, double pv, double feedforward = 0) {
+      _pv[lane] = pv;
+      _feedforward[lane] = feedforward;
+    }
+
+    // Disabled lanes keep their state and output 0, as a PIDController that isn't being called.
+    void SetEnabled(size_t lane, bool enabled) {
+      _enabled[lane] = enabled ? 1 : 0;
+    }
+
+    double GetOutput(size_t lane) const { return _out[lane]; }
+
+    /**
+     * Run every enabled lane once with the inputs given to SetInput.
+     */
+    void Calculate(units::second_t dt) {
+      double t = dt.value(), inverseT = 1.0 / t;
+
+      std::array<double, N> error;
+      for (size_t i = 0; i < N; i++)
+        error[i] = _setpoint[i] - _pv[i];
+      for (size_t i = 0; i < N; i++)
+        if (_wrap[i] > 0) error[i] = Wrap(error[i], _wrap[i]);
+
+      // Branch-free, so the compiler can vectorise across lanes.
+      std::array<double, N> deriv;
+      for (size_t i = 0; i < N; i++) {
+        bool on = _enabled[i];
+        double integral = _integral[i] + error[i] * t;
+        integral = (_izone[i] > 0 && (error[i] > _izone[i] || error[i] < -_izone[i])) ? 0 : integral;
+        deriv[i] = _iterations[i] > 0 ? (_pv[i] - _lastPv[i]) * inverseT : 0;
+
+        _out[i] = on ? _kp[i] * error[i] + _ki[i] * integral + _kd[i] * deriv[i] + _feedforward[i] : 0;
+        _integral[i] = on ? integral : _integral[i];
+        _lastPv[i] = on ? _pv[i] : _lastPv[i];
+        _lastError[i] = on ? error[i] : _lastError[i];
+        _iterations[i] += on;
+      }
+
+      // Stability averages, as MovingAverage over each lane's own window.
+      for (size_t i = 0; i < N; i++) {
+        if (!_enabled[i]) continue;
+        double *pos = _posHistory[i].data(), *vel = _velHistory[i].data();
+        size_t slot = _next[i];
+        _posSum[i] += error[i] - pos[slot];
+        _velSum[i] += deriv[i] - vel[slot];
+        pos[slot] = error[i];
+        vel[slot] = deriv[i];
+        if (++slot == kStabilityWindow) {
+          slot = 0;
+          _posSum[i] = _velSum[i] = 0;
+          for (size_t k = 0; k < kStabilityWindow; k++) {
+            _posSum[i] += pos[k];
+            _velSum[i] += vel[k];
+          }
+        }
+        _next[i] = slot;
+      }
+    }
+
+    bool IsStable(size_t lane, std::optional<double> stableThreshOverride = {}, std::optional<double> velocityThreshOverride = {}) const {
+      double stableThresh = stableThreshOverride.value_or(_stableThresh[lane]);
+      double stableDerivThresh = velocityThreshOverride.value_or(_stableDerivThresh[lane]);
+
+      return _iterations[lane] > (int)kStabilityWindow
+        && std::abs(_posSum[lane] / kStabilityWindow) <= std::abs(stableThresh)
+        && (stableDerivThresh < 0 || std::abs(_velSum[lane] / kStabilityWindow) <= stableDerivThresh);
+    }
+
+    // Clear the integral term, as PIDController::Reset.
+    void Reset(size_t lane) {
+      _integral[lane] = 0;
+    }
+
+    void Reset() {
+      _integral.fill(0);
+    }
+
+    static constexpr size_t Size() { return N; }
+
+   private:
+    static constexpr size_t kStabilityWindow = 20;
+
+    // As PIDController's wrap.
+    static double Wrap(double v, double wr) {
+      v = std::fmod(v, wr);
+      if (std::abs(v) > (wr / 2.0))
+        return (v > 0) ? v - wr : v + wr;
+      return v;
+    }
+
+    template<typename T>
+    static std::array<T, N> Filled(T v) {
+      std::array<T, N> a;
+      a.fill(v);
+      return a;
+    }
+
+    std::array<double, N> _kp{}, _ki{}, _kd{};
+    std::array<double, N> _izone = Filled(-1.0), _stableThresh = Filled(-1.0), _stableDerivThresh = Filled(-1.0);
+    std::array<double, N> _wrap{};
+
+    std::array<double, N> _setpoint{}, _pv{}, _feedforward{}, _out{};
+    std::array<double, N> _integral{}, _lastPv{}, _lastError{};
+    std::array<int, N> _iterations{};
+    std::array<int, N> _enabled = Filled(1);
+
+    std::array<std::array<double, kStabilityWindow>, N> _posHistory{}, _velHistory{};
+    std::array<double, N> _posSum{}, _velSum{};
+    std::array<size_t, N> _next{};
+  };
+}
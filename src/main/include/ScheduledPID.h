@@ -0,0 +1,71 @@
+#pragma once
+
+#include "LUT.h"
+#include "PID.h"
+
+#include <cstddef>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace wom {
+  /**
+   * A PIDController whose kP, kI and kD vary with a scheduling variable, e.g. an arm's angle or an
+   * elevator's height, instead of rebuilding the PIDConfig as it moves. Each gain is looked up in its
+   * own table: anything with a const Estimate(KEY) returning that gain, such as a LUT or StaticLUT.
+   * The thresholds and izone still come from config, and config's kP/kI/kD are unused.
+   *
+   * Calculate looks the gains up every call without allocating. The key is the process variable
+   * unless one is passed. As with any change to kI, a schedule that moves kI quickly will kick the
+   * output through the accumulated integral.
+   */
+  template<typename IN, typename OUT, typename KEY, typename KP_TABLE, typename KI_TABLE, typename KD_TABLE>
+  class ScheduledPIDController : public PIDController<IN, OUT> {
+   public:
+    using base_t = PIDController<IN, OUT>;
+    using config_t = typename base_t::config_t;
+    using gains_t = typename config_t::Gains;
+    using in_t = typename base_t::in_t;
+    using out_t = typename base_t::out_t;
+
+    ScheduledPIDController(std::string path, config_t initialGains, KP_TABLE kp, KI_TABLE ki, KD_TABLE kd, in_t setpoint = in_t{0}, PIDTelemetry telemetry = PIDTelemetry::kFull)
+      : base_t(path, initialGains, setpoint, telemetry), _kp(std::move(kp)), _ki(std::move(ki)), _kd(std::move(kd)) {}
+
+    // Scheduled on the process variable.
+    out_t Calculate(in_t pv, units::second_t dt, out_t feedforward = out_t{0}) requires std::is_same_v<KEY, in_t> {
+      return base_t::Calculate(pv, dt, GetGains(pv), feedforward);
+    }
+
+    // Scheduled on another signal, e.g. elevator height for the arm.
+    out_t Calculate(in_t pv, KEY key, units::second_t dt, out_t feedforward = out_t{0}) {
+      return base_t::Calculate(pv, dt, GetGains(key), feedforward);
+    }
+
+    gains_t GetGains(KEY key) const {
+      gains_t gains = this->config.GetGains();
+      gains.kp = _kp.Estimate(key);
+      gains.ki = _ki.Estimate(key);
+      gains.kd = _kd.Estimate(key);
+      return gains;
+    }
+
+   private:
+    KP_TABLE _kp;
+    KI_TABLE _ki;
+    KD_TABLE _kd;
+  };
+
+  /**
+   * Gains scheduled from LUTs, built at runtime.
+   */
+  template<typename IN, typename OUT, typename KEY = units::unit_t<IN>>
+  using LUTScheduledPIDController = ScheduledPIDController<IN, OUT, KEY,
+    LUT<KEY, typename PIDConfig<IN, OUT>::kp_t>, LUT<KEY, typename PIDConfig<IN, OUT>::ki_t>, LUT<KEY, typename PIDConfig<IN, OUT>::kd_t>>;
+
+  /**
+   * Gains scheduled from StaticLUTs of N points, for schedules fixed at build time.
+   */
+  template<typename IN, typename OUT, size_t N, typename KEY = units::unit_t<IN>>
+  using StaticScheduledPIDController = ScheduledPIDController<IN, OUT, KEY,
+    StaticLUT<KEY, typename PIDConfig<IN, OUT>::kp_t, N>, StaticLUT<KEY, typename PIDConfig<IN, OUT>::ki_t, N>, StaticLUT<KEY, typename PIDConfig<IN, OUT>::kd_t, N>>;
+}
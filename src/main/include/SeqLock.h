@@ -0,0 +1,88 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <type_traits>
+
+namespace wom {
+  /**
+   * A small value written on one thread and read on another without tearing, e.g. PID gains set
+   * from an NT listener and read every tick by Calculate.
+   *
+   * Readers take no lock and don't allocate: they copy the value and retry if a write overlapped
+   * the copy (a sequence lock). Writers are serialised by a mutex and never wait on readers. Best
+   * for values that are read often and written rarely.
+   */
+  template<typename T>
+  class SeqLock {
+   public:
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock values must be trivially copyable");
+
+    SeqLock(const T &value = T{}) {
+      Write(value);
+    }
+
+    SeqLock(const SeqLock &) = delete;
+    SeqLock &operator=(const SeqLock &) = delete;
+
+    T Load() const {
+      std::array<uint64_t, kWords> words;
+      uint64_t before, after;
+      do {
+        before = _sequence.load(std::memory_order_acquire);
+        for (size_t i = 0; i < kWords; i++)
+          words[i] = _words[i].load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = _sequence.load(std::memory_order_relaxed);
+      } while ((before & 1) || before != after);
+
+      T value;
+      std::memcpy(static_cast<void *>(&value), words.data(), sizeof(T));
+      return value;
+    }
+
+    void Store(const T &value) {
+      std::lock_guard<std::mutex> lock{ _writeMutex };
+      Write(value);
+    }
+
+    /**
+     * Change part of the value, e.g. one gain. f is called with a copy of the current value to
+     * modify, and the result is published as a whole.
+     */
+    template<typename F>
+    void Update(F &&f) {
+      std::lock_guard<std::mutex> lock{ _writeMutex };
+      T value = Load();
+      f(value);
+      Write(value);
+    }
+
+    // Incremented by every write.
+    uint64_t GetVersion() const { return _sequence.load() / 2; }
+
+   private:
+    static constexpr size_t kWords = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+    // Odd while a write is in progress.
+    void Write(const T &value) {
+      std::array<uint64_t, kWords> words{};
+      std::memcpy(words.data(), &value, sizeof(T));
+
+      uint64_t sequence = _sequence.load(std::memory_order_relaxed);
+      _sequence.store(sequence + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      for (size_t i = 0; i < kWords; i++)
+        _words[i].store(words[i], std::memory_order_relaxed);
+      _sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    std::array<std::atomic<uint64_t>, kWords> _words{};
+    std::atomic<uint64_t> _sequence{ 0 };
+    std::mutex _writeMutex;
+  };
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace wom {
+  /**
+   * A fixed set of worker threads for splitting a loop across cores, e.g. rows of a grid or a
+   * batch of path queries. The calling thread joins in, so a pool of N threads runs on N + 1 cores.
+   *
+   * Work is scheduled by stealing: each thread starts with an even share of the index range and
+   * takes from its front, and a thread that runs out steals the back half of another's share. Uneven
+   * items (e.g. a few long searches among short ones) balance out without a shared queue.
+   */
+  class ThreadPool {
+   public:
+    explicit ThreadPool(unsigned int threads = DefaultThreads());
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * @return ThreadPool& A pool shared by the library, sized to the machine.
+     */
+    static ThreadPool &Global();
+
+    /**
+     * @return unsigned int One less than the number of hardware threads, as the caller works too.
+     */
+    static unsigned int DefaultThreads();
+
+    /**
+     * @return size_t The number of threads that work on a ParallelFor, including the caller.
+     */
+    size_t Concurrency() const { return _threads.size() + 1; }
+
+    /**
+     * Call fn(i) for every i in [0, count), spread across the pool, and wait for all of them.
+     * Calls run concurrently, so fn must be safe to call from several threads at once, and must
+     * not throw. A ParallelFor from inside fn runs serially on the calling thread.
+     */
+    void ParallelFor(size_t count, const std::function<void(size_t)> &fn);
+
+    /**
+     * As above, also passing the index in [0, Concurrency()) of the thread making the call, e.g.
+     * to pick per-thread scratch space. Calls with the same worker index never overlap.
+     */
+    void ParallelFor(size_t count, const std::function<void(size_t index, size_t worker)> &fn);
+
+   private:
+    // A thread's remaining share of the range, packed as (begin << 32) | end.
+    struct alignas(64) Slot {
+      std::atomic<uint64_t> range{0};
+    };
+
+    void Worker(size_t worker);
+    void Run(size_t worker);
+    bool Take(size_t worker, size_t &index);
+    bool Steal(size_t worker, size_t &index);
+
+    std::vector<std::thread> _threads;
+    std::unique_ptr<Slot[]> _slots;
+
+    std::mutex _dispatchMutex;  // One ParallelFor at a time.
+    std::mutex _mutex;
+    std::condition_variable _wake, _done;
+    uint64_t _generation = 0;
+    size_t _busy = 0;
+    bool _stop = false;
+
+    const std::function<void(size_t, size_t)> *_job = nullptr;
+  };
+}
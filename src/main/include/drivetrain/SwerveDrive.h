@@ -7,6 +7,7 @@
 #include "VoltageController.h"
 #include <frc/interfaces/Gyro.h>
 #include "PID.h"
+#include "PIDBank.h"
 
 #include <units/angular_velocity.h>
 #include <units/charge.h>
@@ -42,6 +43,11 @@ namespace wom {
 
     SwerveModule(std::string path, SwerveModuleConfig config, angle_pid_conf_t anglePID, velocity_pid_conf_t velocityPID);
     void OnUpdate(units::second_t dt);
+    /**
+     * Drive the motors with PID outputs computed elsewhere rather than by the module's own
+     * controllers. Used by SwerveDrive when its module loops run in a PIDBank.
+     */
+    void OnUpdate(units::second_t dt, units::volt_t driveVoltage, units::volt_t turnVoltage);
     void OnStart();
 
     /**
@@ -67,6 +73,12 @@ namespace wom {
 
     units::meters_per_second_t GetSpeed() const;
     units::meter_t GetDistance() const;
+    units::radian_t GetTurnAngle() const;
+
+    bool IsPIDActive() const;
+    units::volt_t GetDriveFeedforward() const;
+    PIDController<units::radians, units::volt> &GetAnglePIDController();
+    PIDController<units::meters_per_second, units::volt> &GetVelocityPIDController();
 
     const SwerveModuleConfig &GetConfig() const;
 
@@ -184,9 +196,22 @@ namespace wom {
 
     SwerveDriveConfig &GetConfig() { return _config; }
 
+    static constexpr size_t kModuleCount = 4;
+
+    /**
+     * Evaluate the eight module angle and velocity loops together in one PIDBank instead of one
+     * PIDController at a time. Off by default. The bank publishes no per-controller NT telemetry.
+     *
+     * While enabled, the modules' own PIDControllers still hold the setpoints and gains but are
+     * not Calculated, so their GetError, IsStable and telemetry stop updating.
+     */
+    void UsePIDBank(bool enable);
+
    protected:
 
    private:
+    void UpdateModulesBanked(units::second_t dt);
+
     SwerveDriveConfig _config;
     SwerveDriveState _state = SwerveDriveState::kIdle;
     std::vector<SwerveModule> _modules;
@@ -204,6 +229,9 @@ namespace wom {
     PIDController<units::meter, units::meters_per_second> _xPIDController;
     PIDController<units::meter, units::meters_per_second> _yPIDController;
 
+    PIDBank<2 * kModuleCount> _moduleBank;
+    bool _usePIDBank = false;
+
     std::shared_ptr<nt::NetworkTable> _table;
 
     bool _isFieldRelative = true;
@@ -0,0 +1,268 @@
+#pragma once
+
+#include "Grid.h"
+
+#include <units/time.h>
+
+#include <chrono>
+
+namespace wom {
+  /**
+   * Anytime Repairing A* (ARA*) over a DiscretisedOccupancyGrid.
+   *
+   * The first path comes from a heavily weighted (greedy, cheap) search, which is then improved by
+   * repeated searches with a smaller weight, reusing the previous search effort, until the weight
+   * reaches 1 and the path is optimal. Work is bounded per call by an expansion count or a time
+   * budget, and carries over between calls, so a behaviour can call Plan every period and get the
+   * best path found so far without blowing its deadline.
+   *
+   * The query restarts from the initial weight when the start, end, grid or traversal costs change.
+   */
+  template<typename GridT, typename CostT>
+  class AnytimePlanner {
+   public:
+    using Idx_t = typename GridT::Idx_t;
+    using path_node_t = typename GridT::template GridPathNode<CostT>;
+    using dx_cost_t = typename GridT::template converting_unit<typename GridT::X_t::unit_type, CostT>;
+    using dy_cost_t = typename GridT::template converting_unit<typename GridT::Y_t::unit_type, CostT>;
+
+    AnytimePlanner(GridT &grid, dx_cost_t dxCost, dy_cost_t dyCost, double initialEpsilon = 3.0, double epsilonStep = 0.5)
+      : _grid(grid), _dxCost(dxCost), _dyCost(dyCost), _initialEpsilon(initialEpsilon), _epsilonStep(epsilonStep) {}
+
+    // Will plan from the closest non-obstacle nodes at the start and end.
+    template<typename BudgetT>
+    std::deque<path_node_t> Plan(Idx_t start, Idx_t end, BudgetT budget) {
+      return PlanStrict(_grid.GetClosestValidNode(start), _grid.GetClosestValidNode(end), budget);
+    }
+
+    /**
+     * Continue (or begin) planning from start to end within the budget, which is either a maximum
+     * number of expansions (size_t) or a time (units::second_t). Returns the best path so far, which is
+     * blank if none has been found yet, or if either the start or the end are in obstacles.
+     */
+    template<typename BudgetT>
+    std::deque<path_node_t> PlanStrict(Idx_t start, Idx_t end, BudgetT budget) {
+      Query(start, end);
+      Improve(budget);
+      return GetPath();
+    }
+
+    /**
+     * Start a new query if the start, end or grid have changed since the last one.
+     */
+    void Query(Idx_t start, Idx_t end) {
+      if (_active && start == _startPos && end == _endPos && _grid.GetVersion() == _version
+        && _grid.GetTraversalVersion() == _traversalVersion)
+        return;
+
+      _active = true;
+      _startPos = start;
+      _endPos = end;
+      _version = _grid.GetVersion();
+      _traversalVersion = _grid.GetTraversalVersion();
+      _start = _grid.IndexOf(start);
+      _goal = _grid.IndexOf(end);
+      _path.clear();
+      _pathEpsilon = std::numeric_limits<double>::infinity();
+      _done = _grid.Get(start) || _grid.Get(end);
+
+      size_t n = _grid.CellCount();
+      if (_cells.size() != n) {
+        _cells.assign(n, Cell{});
+        _open.Resize(n);
+        _query = 0;
+        _iteration = 0;
+      }
+      _open.Clear();
+      _incons.clear();
+      _query++;
+      _iteration++;
+
+      for (int dx = -1; dx <= 1; dx++)
+        for (int dy = -1; dy <= 1; dy++)
+          _stepCost[(dx + 1) * 3 + (dy + 1)] = _grid.template Cost<CostT>(Idx_t{0, 0}, Idx_t{dx, dy}, _dxCost, _dyCost).value();
+
+      if (_done) return;
+      _epsilon = _initialEpsilon;
+      At(_start).g = 0;
+      _open.Push(_start, Key(_start));
+      _searching = true;
+    }
+
+    /**
+     * Spend up to maxExpansions improving the current query. Returns true once the path is optimal
+     * (or the end is known to be unreachable).
+     */
+    bool Improve(size_t maxExpansions) {
+      return Improve(maxExpansions, std::chrono::steady_clock::time_point::max());
+    }
+
+    /**
+     * Spend up to the given time improving the current query. Returns true once the path is optimal
+     * (or the end is known to be unreachable).
+     */
+    bool Improve(units::second_t budget) {
+      auto deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(budget.value())
+      );
+      return Improve(std::numeric_limits<size_t>::max(), deadline);
+    }
+
+    /**
+     * Get the best path found so far.
+     */
+    std::deque<path_node_t> GetPath() const {
+      std::deque<path_node_t> path;
+      double cost = 0;
+      for (size_t i = 0; i < _path.size(); i++) {
+        if (i > 0) cost += StepCost(_path[i - 1], _path[i]) * _grid.GetTraversalMultiplier(_grid.PositionOf(_path[i]));
+        path.push_back(path_node_t{ _grid.CenterOf(_grid.PositionOf(_path[i])), units::unit_t<CostT>{cost} });
+      }
+      return path;
+    }
+
+    /**
+     * Get the suboptimality bound of the best path: its cost is at most this times the optimal cost.
+     * Infinite if there is no path yet.
+     */
+    double GetEpsilon() const { return _pathEpsilon; }
+
+    /**
+     * Whether the current query is finished, i.e. the path is optimal or there is none.
+     */
+    bool IsDone() const { return _done; }
+
+    /**
+     * Get the number of nodes expanded by the last call to Improve.
+     */
+    size_t GetExpansions() const { return _expansions; }
+
+   private:
+    using key_t = std::pair<double, double>;
+
+    struct Cell {
+      double g;
+      int parent;
+      uint32_t query = 0;  // Cells from an older query are stale.
+      uint32_t closed = 0;  // Closed in the iteration with this number.
+      bool incons;
+    };
+
+    Cell &At(int idx) {
+      Cell &cell = _cells[idx];
+      if (cell.query != _query) {
+        cell.g = std::numeric_limits<double>::infinity();
+        cell.parent = -1;
+        cell.query = _query;
+        cell.closed = 0;
+        cell.incons = false;
+      }
+      return cell;
+    }
+
+    double StepCost(int a, int b) const {
+      Idx_t d = _grid.PositionOf(b) - _grid.PositionOf(a);
+      return _stepCost[(d.x() + 1) * 3 + (d.y() + 1)];
+    }
+
+    key_t Key(int idx) {
+      double h = _grid.template Cost<CostT>(_grid.PositionOf(idx), _endPos, _dxCost, _dyCost).value();
+      return key_t{ At(idx).g + _epsilon * h, h };
+    }
+
+    bool Improve(size_t maxExpansions, std::chrono::steady_clock::time_point deadline) {
+      _expansions = 0;
+      while (!_done) {
+        if (!_searching) NextIteration();
+
+        // ImprovePath: expand until the goal cannot be bettered under the current weight.
+        while (!_open.Empty() && At(_goal).g > _open.TopKey().first) {
+          if (_expansions >= maxExpansions || ((_expansions & 63) == 0 && std::chrono::steady_clock::now() >= deadline))
+            return false;
+          Expand(_open.Pop());
+          _expansions++;
+        }
+
+        _searching = false;
+        if (std::isinf(At(_goal).g)) {
+          _done = true;
+        } else {
+          Publish();
+          _done = _epsilon <= 1;
+        }
+      }
+      return true;
+    }
+
+    void Expand(int current) {
+      Cell &currentCell = At(current);
+      currentCell.closed = _iteration;
+      Idx_t pos = _grid.PositionOf(current);
+      for (int dx = -1; dx <= 1; dx++) {
+        for (int dy = -1; dy <= 1; dy++) {
+          if (dx == 0 && dy == 0) continue;
+          Idx_t next = pos + Idx_t{ dx, dy };
+          if (_grid.Get(next)) continue;
+
+          int idx = _grid.IndexOf(next);
+          Cell &nextCell = At(idx);
+          double tentative = currentCell.g + _stepCost[(dx + 1) * 3 + (dy + 1)] * _grid.GetTraversalMultiplier(next);
+          if (tentative < nextCell.g) {
+            nextCell.g = tentative;
+            nextCell.parent = current;
+            if (nextCell.closed != _iteration) {
+              _open.Push(idx, Key(idx));
+            } else if (!nextCell.incons) {
+              nextCell.incons = true;
+              _incons.push_back(idx);
+            }
+          }
+        }
+      }
+    }
+
+    // Lower the weight and reopen the cells that became inconsistent after being closed.
+    void NextIteration() {
+      _epsilon = std::max(1.0, _epsilon - _epsilonStep);
+      _iteration++;
+
+      _rekey.clear();
+      while (!_open.Empty()) _rekey.push_back(_open.Pop());
+      for (int idx : _incons) {
+        At(idx).incons = false;
+        _rekey.push_back(idx);
+      }
+      _incons.clear();
+      for (int idx : _rekey) _open.Push(idx, Key(idx));
+      _searching = true;
+    }
+
+    void Publish() {
+      _path.clear();
+      for (int i = _goal; i >= 0; i = At(i).parent) _path.push_back(i);
+      std::reverse(_path.begin(), _path.end());
+      _pathEpsilon = _epsilon;
+    }
+
+    GridT &_grid;
+    dx_cost_t _dxCost;
+    dy_cost_t _dyCost;
+    double _initialEpsilon, _epsilonStep;
+
+    bool _active = false, _searching = false, _done = true;
+    Idx_t _startPos, _endPos;
+    uint64_t _version = 0, _traversalVersion = 0;
+    int _start = 0, _goal = 0;
+    double _epsilon = 1;
+
+    std::vector<Cell> _cells;
+    uint32_t _query = 0, _iteration = 0;
+    detail::IndexedHeap<key_t> _open;
+    std::vector<int> _incons, _rekey;
+    std::array<double, 9> _stepCost;
+
+    std::vector<int> _path;
+    double _pathEpsilon = std::numeric_limits<double>::infinity();
+    size_t _expansions = 0;
+  };
+}
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace wom {
+  /**
+   * Exact Euclidean distance transform of an occupancy grid, computed in linear time with the
+   * separable lower-envelope algorithm of Felzenszwalb & Huttenlocher. Cells are cellWidth x
+   * cellHeight, so anisotropic cells are handled exactly.
+   *
+   * Two fields are kept:
+   *  - Clearance: the distance from each cell centre to the nearest occupied cell centre, or to the
+   *    grid boundary (which counts as occupied), whichever is nearer.
+   *  - Nearest free: for each cell, the flat index of the nearest free cell.
+   *
+   * The per-column pass is cached, so after a few cells change only their columns are redone
+   * before the (cheap) per-row pass.
+   */
+  class DistanceField {
+   public:
+    static constexpr int npos = -1;
+
+    /**
+     * Recompute both fields. occupied(x, y) must return whether the in-bounds cell is occupied.
+     */
+    template<typename F>
+    void Rebuild(int cols, int rows, double cellWidth, double cellHeight, F &&occupied) {
+      _cols = cols;
+      _rows = rows;
+      _w2 = cellWidth * cellWidth;
+      _h2 = cellHeight * cellHeight;
+
+      size_t n = (size_t)cols * rows;
+      _colClear.resize(n);
+      _colFree.resize(n);
+      _colFreeSrc.resize(n);
+      _clearance2.resize(n);
+      _nearestFree.resize(n);
+
+      for (int x = 0; x < cols; x++)
+        ColumnPass(x, occupied);
+      RowPass();
+    }
+
+    /**
+     * Bring the fields up to date after changes to the given columns, with occupied as in Rebuild.
+     */
+    template<typename F>
+    void Update(const std::vector<int> &dirtyColumns, F &&occupied) {
+      for (int x : dirtyColumns)
+        ColumnPass(x, occupied);
+      RowPass();
+    }
+
+    bool Empty() const { return _clearance2.empty(); }
+    int Cols() const { return _cols; }
+    int Rows() const { return _rows; }
+
+    /**
+     * Distance from the cell to the nearest occupied cell or the grid boundary. 0 if occupied.
+     */
+    double Clearance(int x, int y) const {
+      return std::sqrt(_clearance2[(size_t)y * _cols + x]);
+    }
+
+    /**
+     * Flat index (y * cols + x) of the nearest free cell, or npos if there are none.
+     */
+    int NearestFree(int x, int y) const {
+      return _nearestFree[(size_t)y * _cols + x];
+    }
+
+   private:
+    static constexpr double kInf = std::numeric_limits<double>::infinity();
+
+    // 1D squared distance transform of f (n samples, spacing^2 = w2), writing the distance and the
+    // index of the source sample. Samples with f = inf never become sources.
+    void Transform1D(const double *f, int n, double w2, double *d, int *src) {
+      _v.resize(n);
+      _z.resize(n + 1);
+
+      int k = -1;
+      for (int q = 0; q < n; q++) {
+        if (f[q] == kInf) continue;
+        if (k < 0) {
+          k = 0;
+          _v[0] = q;
+          _z[0] = -kInf;
+          _z[1] = kInf;
+          continue;
+        }
+
+        double s;
+        while (true) {
+          int p = _v[k];
+          s = ((f[q] + w2 * q * q) - (f[p] + w2 * p * p)) / (2 * w2 * (q - p));
+          if (s <= _z[k]) k--;
+          else break;
+        }
+        k++;
+        _v[k] = q;
+        _z[k] = s;
+        _z[k + 1] = kInf;
+      }
+
+      if (k < 0) {
+        std::fill(d, d + n, kInf);
+        std::fill(src, src + n, npos);
+        return;
+      }
+
+      k = 0;
+      for (int q = 0; q < n; q++) {
+        while (_z[k + 1] < q) k++;
+        int p = _v[k];
+        d[q] = w2 * (q - p) * (q - p) + f[p];
+        src[q] = p;
+      }
+    }
+
+    template<typename F>
+    void ColumnPass(int x, F &&occupied) {
+      _f.resize(_rows);
+      _d.resize(_rows);
+      _src.resize(_rows);
+
+      // Distance to occupied cells, then to free cells.
+      for (int y = 0; y < _rows; y++)
+        _f[y] = occupied(x, y) ? 0 : kInf;
+      Transform1D(_f.data(), _rows, _h2, _d.data(), _src.data());
+      for (int y = 0; y < _rows; y++)
+        _colClear[(size_t)y * _cols + x] = (float)_d[y];
+
+      for (int y = 0; y < _rows; y++)
+        _f[y] = (_f[y] == 0) ? kInf : 0;
+      Transform1D(_f.data(), _rows, _h2, _d.data(), _src.data());
+      for (int y = 0; y < _rows; y++) {
+        _colFree[(size_t)y * _cols + x] = (float)_d[y];
+        _colFreeSrc[(size_t)y * _cols + x] = _src[y];
+      }
+    }
+
+    void RowPass() {
+      _f.resize(_cols);
+      _d.resize(_cols);
+      _src.resize(_cols);
+
+      for (int y = 0; y < _rows; y++) {
+        size_t row = (size_t)y * _cols;
+        double yBorder = std::min(y + 1, _rows - y);
+
+        std::copy(_colClear.begin() + row, _colClear.begin() + row + _cols, _f.begin());
+        Transform1D(_f.data(), _cols, _w2, _d.data(), _src.data());
+        for (int x = 0; x < _cols; x++) {
+          // The boundary is an occupied wall one cell beyond the edge.
+          double xBorder = std::min(x + 1, _cols - x);
+          _clearance2[row + x] = (float)std::min({ _d[x], _w2 * xBorder * xBorder, _h2 * yBorder * yBorder });
+        }
+
+        std::copy(_colFree.begin() + row, _colFree.begin() + row + _cols, _f.begin());
+        Transform1D(_f.data(), _cols, _w2, _d.data(), _src.data());
+        for (int x = 0; x < _cols; x++) {
+          int srcX = _src[x];
+          _nearestFree[row + x] = (srcX == npos) ? npos : _colFreeSrc[row + srcX] * _cols + srcX;
+        }
+      }
+    }
+
+    int _cols = 0, _rows = 0;
+    double _w2 = 1, _h2 = 1;
+
+    // Squared distances along each column, and the row of the nearest free cell in the column.
+    // Stored as float to halve the footprint; the transforms themselves run in double.
+    std::vector<float> _colClear, _colFree;
+    std::vector<int> _colFreeSrc;
+
+    std::vector<float> _clearance2;
+    std::vector<int> _nearestFree;
+
+    // Scratch for the 1D transforms.
+    std::vector<double> _f, _d, _z;
+    std::vector<int> _src, _v;
+  };
+}
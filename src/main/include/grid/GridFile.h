@@ -0,0 +1,209 @@
+#pragma once
+
+#include "Grid.h"
+
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace wom {
+  /**
+   * On-disk format for occupancy grids, so field maps can be built once and loaded at boot.
+   *
+   * A 64-byte header (GridFileHeader) is followed by the payload at offset 64:
+   *  - kBitPacked: rows x ceil(cols / 64) little-endian 64-bit words, row-major, bit x % 64 of word
+   *    x / 64 set for occupied cells and padding bits clear. This is BitPackedOccupancy's own
+   *    layout, so a mapped file can be used in place.
+   *  - kRLE: 32-bit run lengths over the cells in row-major order, alternating free / occupied and
+   *    starting with free (so the first run may be 0). Small for maps made of large shapes.
+   *
+   * Bounds are stored in the grid's own X / Y units. All values are little-endian, as on the
+   * roboRIO and desktop targets.
+   */
+  enum class GridFileEncoding : uint16_t {
+    kBitPacked = 0,
+    kRLE = 1
+  };
+
+  struct GridFileHeader {
+    static constexpr char kMagic[4] = { 'W', 'G', 'R', 'D' };
+    static constexpr uint16_t kVersion = 1;
+
+    char magic[4];
+    uint16_t version;
+    GridFileEncoding encoding;
+    uint32_t cols, rows;
+    double xmin, xmax, ymin, ymax;
+    uint64_t payloadSize;
+    uint64_t reserved;
+  };
+  static_assert(sizeof(GridFileHeader) == 64, "GridFileHeader must stay 64 bytes");
+
+  /**
+   * A read-only file mapped into memory (or, where mapping is unavailable, read in one go).
+   */
+  class MappedFile {
+   public:
+    static std::shared_ptr<const MappedFile> Open(const std::string &path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    const uint8_t *Data() const { return _data; }
+    size_t Size() const { return _size; }
+
+   private:
+    MappedFile() = default;
+
+    const uint8_t *_data = nullptr;
+    size_t _size = 0;
+    bool _mapped = false;
+    std::unique_ptr<uint8_t[]> _buffer;
+  };
+
+  /**
+   * Write grid to path in the given encoding.
+   */
+  template<typename T_X, typename T_Y, typename Storage>
+  void SaveGrid(const std::string &path, const DiscretisedOccupancyGrid<T_X, T_Y, Storage> &grid, GridFileEncoding encoding = GridFileEncoding::kBitPacked) {
+    const Storage &storage = grid._grid;
+    const int rows = (int)storage.rows(), cols = (int)storage.cols();
+
+    GridFileHeader header{};
+    std::memcpy(header.magic, GridFileHeader::kMagic, sizeof(header.magic));
+    header.version = GridFileHeader::kVersion;
+    header.encoding = encoding;
+    header.cols = (uint32_t)cols;
+    header.rows = (uint32_t)rows;
+    header.xmin = grid._xmin.value();
+    header.xmax = grid._xmax.value();
+    header.ymin = grid._ymin.value();
+    header.ymax = grid._ymax.value();
+
+    std::vector<uint8_t> payload;
+    if (encoding == GridFileEncoding::kBitPacked) {
+      BitPackedOccupancy packed{ (size_t)rows, (size_t)cols };
+      if constexpr (std::is_same_v<Storage, BitPackedOccupancy>) {
+        packed = storage;
+      } else {
+        for (int y = 0; y < rows; y++)
+          for (int x = 0; x < cols; x++)
+            if (storage.Get(y, x)) packed.Set(y, x, true);
+      }
+      size_t rowBytes = packed.WordsPerRow() * sizeof(BitPackedOccupancy::word_t);
+      payload.resize(rows * rowBytes);
+      for (int y = 0; y < rows; y++)
+        std::memcpy(payload.data() + y * rowBytes, packed.Row(y), rowBytes);
+    } else {
+      auto pushRun = [&payload](uint32_t run) {
+        payload.insert(payload.end(), (uint8_t *)&run, (uint8_t *)&run + sizeof(run));
+      };
+      bool current = false;
+      uint32_t run = 0;
+      for (int y = 0; y < rows; y++) {
+        for (int x = 0; x < cols; x++) {
+          if (storage.Get(y, x) != current) {
+            pushRun(run);
+            current = !current;
+            run = 0;
+          }
+          run++;
+        }
+      }
+      pushRun(run);
+    }
+    header.payloadSize = payload.size();
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+      throw std::runtime_error("Could not open grid file for writing: " + path);
+    out.write((const char *)&header, sizeof(header));
+    out.write((const char *)payload.data(), payload.size());
+    if (!out)
+      throw std::runtime_error("Could not write grid file: " + path);
+  }
+
+  /**
+   * Load a grid saved by SaveGrid. The file is memory-mapped; a bit-packed file loaded into a
+   * BitPackedOccupancy grid is used in place without copying (the mapping stays open while the
+   * grid, or any copy of it, views it, and the first write copies it). Other combinations decode
+   * straight from the mapping.
+   */
+  template<typename GridT>
+  GridT LoadGrid(const std::string &path) {
+    using Storage = typename GridT::storage_t;
+    std::shared_ptr<const MappedFile> file = MappedFile::Open(path);
+
+    if (file->Size() < sizeof(GridFileHeader))
+      throw std::runtime_error("Grid file too short: " + path);
+    GridFileHeader header;
+    std::memcpy(&header, file->Data(), sizeof(header));
+    if (std::memcmp(header.magic, GridFileHeader::kMagic, sizeof(header.magic)) != 0)
+      throw std::runtime_error("Not a grid file: " + path);
+    if (header.version != GridFileHeader::kVersion)
+      throw std::runtime_error("Unsupported grid file version " + std::to_string(header.version) + ": " + path);
+    // Sizes come from the file, so check them in 64 bits: on the 32-bit roboRIO a corrupt header
+    // could otherwise wrap size_t and pass.
+    if (header.payloadSize > (uint64_t)file->Size() - sizeof(GridFileHeader))
+      throw std::runtime_error("Grid file truncated: " + path);
+    // Grids index cells with an int.
+    if ((uint64_t)header.rows * header.cols > (uint64_t)std::numeric_limits<int>::max())
+      throw std::runtime_error("Grid file too large: " + path);
+
+    const size_t rows = header.rows, cols = header.cols;
+    const uint8_t *payload = file->Data() + sizeof(GridFileHeader);
+    typename GridT::X_t xmin{header.xmin}, xmax{header.xmax};
+    typename GridT::Y_t ymin{header.ymin}, ymax{header.ymax};
+
+    if (header.encoding == GridFileEncoding::kBitPacked) {
+      size_t wordsPerRow = (cols + BitPackedOccupancy::kBitsPerWord - 1) / BitPackedOccupancy::kBitsPerWord;
+      if (header.payloadSize != (uint64_t)rows * wordsPerRow * sizeof(BitPackedOccupancy::word_t))
+        throw std::runtime_error("Grid file payload size mismatch: " + path);
+
+      // The payload is 64 bytes into a page-aligned mapping, so the words are aligned.
+      auto words = reinterpret_cast<const BitPackedOccupancy::word_t *>(payload);
+      BitPackedOccupancy view = BitPackedOccupancy::View(rows, cols, words, file);
+      if constexpr (std::is_same_v<Storage, BitPackedOccupancy>) {
+        return GridT{ xmin, xmax, ymin, ymax, std::move(view) };
+      } else {
+        GridT grid{ xmin, xmax, ymin, ymax, cols, rows };
+        for (size_t y = 0; y < rows; y++)
+          for (size_t x = 0; x < cols; x++)
+            if (view.Get((int)y, (int)x)) grid._grid.Set((int)y, (int)x, true);
+        return grid;
+      }
+    } else if (header.encoding == GridFileEncoding::kRLE) {
+      if (header.payloadSize % sizeof(uint32_t) != 0)
+        throw std::runtime_error("Grid file payload size mismatch: " + path);
+
+      Storage storage{ rows, cols };
+      size_t cell = 0, total = rows * cols;
+      bool occupied = false;
+      for (size_t i = 0; i < header.payloadSize; i += sizeof(uint32_t), occupied = !occupied) {
+        uint32_t run;
+        std::memcpy(&run, payload + i, sizeof(run));
+        if (run > total - cell)
+          throw std::runtime_error("Grid file runs overflow the grid: " + path);
+
+        // Runs may span rows; fill them a row segment at a time.
+        for (size_t end = cell + run; occupied && cell < end;) {
+          size_t y = cell / cols, x = cell % cols;
+          size_t n = std::min(end - cell, cols - x);
+          storage.FillRow((int)y, (int)x, (int)(x + n - 1), true);
+          cell += n;
+        }
+        if (!occupied) cell += run;
+      }
+      if (cell != total)
+        throw std::runtime_error("Grid file runs do not cover the grid: " + path);
+      return GridT{ xmin, xmax, ymin, ymax, std::move(storage) };
+    }
+
+    throw std::runtime_error("Unknown grid file encoding: " + path);
+  }
+}
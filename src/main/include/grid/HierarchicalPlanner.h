@@ -0,0 +1,359 @@
+#pragma once
+
+#include "Grid.h"
+
+namespace wom {
+  /**
+   * Hierarchical path planner (HPA*) over a DiscretisedOccupancyGrid.
+   *
+   * The grid is cut into square clusters. Entrances are placed along each border between clusters,
+   * and the costs between entrances of the same cluster are precomputed. A query then searches
+   * this small abstract graph, and refines each abstract step with a search bounded to one cluster.
+   * Paths are near-optimal rather than optimal, in exchange for much cheaper long queries.
+   *
+   * Changes made through the grid's Set only rebuild the clusters they touch (and their neighbours,
+   * whose entrances are shared). Fill, FillF, Load and Reset rebuild everything. If the abstract
+   * search finds nothing (e.g. the only way through is a diagonal squeeze across a cluster corner)
+   * the query falls back to plain A*, so a path is returned whenever one exists.
+   *
+   * Clusters are built and refined on occupancy only: traversal costs (SetTraversalCost) are
+   * ignored, except by the A* fallback.
+   */
+  template<typename GridT, typename CostT>
+  class HierarchicalPlanner {
+   public:
+    using Idx_t = typename GridT::Idx_t;
+    using path_node_t = typename GridT::template GridPathNode<CostT>;
+    using dx_cost_t = typename GridT::template converting_unit<typename GridT::X_t::unit_type, CostT>;
+    using dy_cost_t = typename GridT::template converting_unit<typename GridT::Y_t::unit_type, CostT>;
+
+    HierarchicalPlanner(GridT &grid, dx_cost_t dxCost, dy_cost_t dyCost, int clusterSize = 16)
+      : _grid(grid), _dxCost(dxCost), _dyCost(dyCost), _clusterSize(clusterSize) {}
+
+    // Will plan from the closest non-obstacle nodes at the start and end.
+    std::deque<path_node_t> Plan(Idx_t start, Idx_t end) {
+      return PlanStrict(_grid.GetClosestValidNode(start), _grid.GetClosestValidNode(end));
+    }
+
+    // Will return a blank path if either the start or the end are in obstacles.
+    std::deque<path_node_t> PlanStrict(Idx_t start, Idx_t end) {
+      _expansions = 0;
+      if (_grid.Get(start) || _grid.Get(end))
+        return std::deque<path_node_t>{};
+
+      Sync();
+
+      std::vector<int> abstractPath;
+      if (!SearchAbstract(_grid.IndexOf(start), _grid.IndexOf(end), abstractPath))
+        return _grid.template AStarStrict<CostT>(start, end, _dxCost, _dyCost);
+
+      // Refine each abstract step into cells.
+      std::vector<int> cells{ abstractPath.front() };
+      for (size_t i = 1; i < abstractPath.size(); i++)
+        Refine(abstractPath[i - 1], abstractPath[i], cells);
+
+      std::deque<path_node_t> path;
+      double cost = 0;
+      for (size_t i = 0; i < cells.size(); i++) {
+        if (i > 0) cost += StepCost(cells[i - 1], cells[i]);
+        path.push_back(path_node_t{ _grid.CenterOf(_grid.PositionOf(cells[i])), units::unit_t<CostT>{cost} });
+      }
+      return path;
+    }
+
+    /**
+     * Get the number of abstract nodes expanded by the last call to Plan.
+     */
+    size_t GetExpansions() const { return _expansions; }
+
+    /**
+     * Get the number of entrance nodes in the abstract graph.
+     */
+    size_t GetAbstractNodeCount() {
+      Sync();
+      size_t n = 0;
+      for (auto &c : _clusters) n += c.nodes.size();
+      return n;
+    }
+
+   private:
+    // Runs at most this long become one entrance in the middle, longer runs get one at each end.
+    static constexpr int kMaxSingleEntrance = 6;
+    static constexpr double kInf = std::numeric_limits<double>::infinity();
+
+    struct Box {
+      int x0, y0, x1, y1;
+      bool Contains(Idx_t p) const { return p.x() >= x0 && p.x() <= x1 && p.y() >= y0 && p.y() <= y1; }
+    };
+
+    struct Link {
+      int local;
+      int partner;
+      double cost;
+    };
+
+    struct Cluster {
+      Box box;
+      std::vector<int> nodes;  // Cells of the entrances on this side of the cluster's borders.
+      std::vector<double> dist;  // nodes.size()^2 costs between entrances, within the cluster.
+      std::vector<Link> links;  // Steps from an entrance across a border.
+    };
+
+    // Bring the abstract graph up to date with the grid.
+    void Sync() {
+      int cols = (int)_grid._grid.cols(), rows = (int)_grid._grid.rows();
+      int ccols = (cols + _clusterSize - 1) / _clusterSize, crows = (rows + _clusterSize - 1) / _clusterSize;
+
+      std::vector<int> dirty;
+      bool full = _clusters.empty() || ccols != _ccols || crows != _crows || _localIndex.size() != _grid.CellCount()
+        || !_grid.ForEachChangeSince(_version, [&](Idx_t changed) { dirty.push_back(ClusterOf(_grid.IndexOf(changed))); });
+
+      if (full) {
+        _ccols = ccols;
+        _crows = crows;
+        _clusters.assign(ccols * crows, Cluster{});
+        _localIndex.assign(_grid.CellCount(), -1);
+        for (int cy = 0; cy < crows; cy++) {
+          for (int cx = 0; cx < ccols; cx++) {
+            int x0 = cx * _clusterSize, y0 = cy * _clusterSize;
+            _clusters[cy * ccols + cx].box = Box{ x0, y0, std::min(cols, x0 + _clusterSize) - 1, std::min(rows, y0 + _clusterSize) - 1 };
+          }
+        }
+        for (int dx = -1; dx <= 1; dx++)
+          for (int dy = -1; dy <= 1; dy++)
+            _stepCost[(dx + 1) * 3 + (dy + 1)] = _grid.template Cost<CostT>(Idx_t{0, 0}, Idx_t{dx, dy}, _dxCost, _dyCost).value();
+
+        dirty.resize(_clusters.size());
+        for (size_t i = 0; i < dirty.size(); i++) dirty[i] = (int)i;
+      }
+
+      if (!dirty.empty()) {
+        // Entrances on a border depend on both sides, so neighbours of a changed cluster change too.
+        std::vector<int> affected;
+        for (int c : dirty) {
+          affected.push_back(c);
+          int cx = c % _ccols, cy = c / _ccols;
+          if (cx > 0) affected.push_back(c - 1);
+          if (cx < _ccols - 1) affected.push_back(c + 1);
+          if (cy > 0) affected.push_back(c - _ccols);
+          if (cy < _crows - 1) affected.push_back(c + _ccols);
+        }
+        std::sort(affected.begin(), affected.end());
+        affected.erase(std::unique(affected.begin(), affected.end()), affected.end());
+
+        for (int c : affected) BuildEntrances(c);
+        for (int c : affected) BuildIntraCosts(c);
+      }
+
+      _version = _grid.GetVersion();
+    }
+
+    int ClusterOf(int cell) const {
+      Idx_t p = _grid.PositionOf(cell);
+      return (p.y() / _clusterSize) * _ccols + p.x() / _clusterSize;
+    }
+
+    double StepCost(int a, int b) const {
+      Idx_t d = _grid.PositionOf(b) - _grid.PositionOf(a);
+      return _stepCost[(d.x() + 1) * 3 + (d.y() + 1)];
+    }
+
+    // Place entrances along the border of cluster c running from `from` in direction `along`, with
+    // the neighbouring cluster's cells at offset `across`.
+    void BuildBorder(Cluster &cluster, Idx_t from, Idx_t along, Idx_t across, int length) {
+      auto addTransition = [&](int i) {
+        Idx_t mine = from + along * i;
+        int cell = _grid.IndexOf(mine);
+        if (_localIndex[cell] < 0) {
+          _localIndex[cell] = (int)cluster.nodes.size();
+          cluster.nodes.push_back(cell);
+        }
+        cluster.links.push_back(Link{ _localIndex[cell], _grid.IndexOf(mine + across), StepCost(cell, _grid.IndexOf(mine + across)) });
+      };
+
+      int runStart = -1;
+      for (int i = 0; i <= length; i++) {
+        bool open = i < length && !_grid.Get(from + along * i) && !_grid.Get(from + along * i + across);
+        if (open && runStart < 0) {
+          runStart = i;
+        } else if (!open && runStart >= 0) {
+          int runEnd = i - 1;
+          if (runEnd - runStart + 1 <= kMaxSingleEntrance) {
+            addTransition((runStart + runEnd) / 2);
+          } else {
+            addTransition(runStart);
+            addTransition(runEnd);
+          }
+          runStart = -1;
+        }
+      }
+    }
+
+    void BuildEntrances(int c) {
+      Cluster &cluster = _clusters[c];
+      for (int cell : cluster.nodes) _localIndex[cell] = -1;
+      cluster.nodes.clear();
+      cluster.links.clear();
+
+      const Box &b = cluster.box;
+      int cx = c % _ccols, cy = c / _ccols;
+      int width = b.x1 - b.x0 + 1, height = b.y1 - b.y0 + 1;
+      if (cx > 0) BuildBorder(cluster, Idx_t{ b.x0, b.y0 }, Idx_t{ 0, 1 }, Idx_t{ -1, 0 }, height);
+      if (cx < _ccols - 1) BuildBorder(cluster, Idx_t{ b.x1, b.y0 }, Idx_t{ 0, 1 }, Idx_t{ 1, 0 }, height);
+      if (cy > 0) BuildBorder(cluster, Idx_t{ b.x0, b.y0 }, Idx_t{ 1, 0 }, Idx_t{ 0, -1 }, width);
+      if (cy < _crows - 1) BuildBorder(cluster, Idx_t{ b.x0, b.y1 }, Idx_t{ 1, 0 }, Idx_t{ 0, 1 }, width);
+    }
+
+    void BuildIntraCosts(int c) {
+      Cluster &cluster = _clusters[c];
+      size_t n = cluster.nodes.size();
+      cluster.dist.assign(n * n, kInf);
+      for (size_t i = 0; i < n; i++) {
+        BoundedSearch(cluster.nodes[i], cluster.box, -1, _local);
+        for (size_t j = 0; j < n; j++)
+          cluster.dist[i * n + j] = _local.At(cluster.nodes[j]).gScore;
+      }
+    }
+
+    // A* from source confined to box. With target < 0 it runs to exhaustion (Dijkstra), leaving the
+    // cost to every reachable cell in the workspace. Returns the cost to target.
+    double BoundedSearch(int source, const Box &box, int target, GridSearchWorkspace &ws) {
+      using key_t = GridSearchWorkspace::key_t;
+      ws.Begin(_grid.CellCount());
+      ws.At(source).gScore = 0;
+      ws.openSet.Push(source, key_t{ 0, 0 });
+
+      Idx_t targetPos = target >= 0 ? _grid.PositionOf(target) : Idx_t{0, 0};
+      while (!ws.openSet.Empty()) {
+        int current = ws.openSet.Pop();
+        if (current == target)
+          return ws.At(current).gScore;
+
+        GridSearchWorkspace::Node &currentNode = ws.At(current);
+        currentNode.closed = true;
+        Idx_t pos = _grid.PositionOf(current);
+        for (int dx = -1; dx <= 1; dx++) {
+          for (int dy = -1; dy <= 1; dy++) {
+            if (dx == 0 && dy == 0) continue;
+            Idx_t next = pos + Idx_t{ dx, dy };
+            if (!box.Contains(next) || _grid.Get(next)) continue;
+
+            int idx = _grid.IndexOf(next);
+            GridSearchWorkspace::Node &nextNode = ws.At(idx);
+            if (nextNode.closed) continue;
+
+            double tentative = currentNode.gScore + _stepCost[(dx + 1) * 3 + (dy + 1)];
+            if (tentative < nextNode.gScore) {
+              nextNode.gScore = tentative;
+              nextNode.parent = current;
+              double h = target >= 0 ? _grid.template Cost<CostT>(next, targetPos, _dxCost, _dyCost).value() : 0;
+              ws.openSet.Push(idx, key_t{ tentative + h, h });
+            }
+          }
+        }
+      }
+      return target >= 0 ? kInf : 0;
+    }
+
+    // Search the abstract graph, with the start and goal connected to the entrances of their clusters.
+    bool SearchAbstract(int start, int goal, std::vector<int> &abstractPath) {
+      using key_t = GridSearchWorkspace::key_t;
+      int startCluster = ClusterOf(start), goalCluster = ClusterOf(goal);
+      Idx_t goalPos = _grid.PositionOf(goal);
+
+      // Costs from the start to its cluster's entrances (and the goal if it shares the cluster).
+      const Cluster &sc = _clusters[startCluster];
+      std::vector<double> startCosts(sc.nodes.size());
+      BoundedSearch(start, sc.box, -1, _local);
+      double directGoal = kInf;
+      for (size_t i = 0; i < sc.nodes.size(); i++) startCosts[i] = _local.At(sc.nodes[i]).gScore;
+      if (startCluster == goalCluster) directGoal = _local.At(goal).gScore;
+
+      // Costs from each of the goal cluster's entrances to the goal. Moves are symmetric.
+      const Cluster &gc = _clusters[goalCluster];
+      std::vector<double> goalCosts(gc.nodes.size());
+      BoundedSearch(goal, gc.box, -1, _local);
+      for (size_t i = 0; i < gc.nodes.size(); i++) goalCosts[i] = _local.At(gc.nodes[i]).gScore;
+
+      GridSearchWorkspace &ws = _abstract;
+      ws.Begin(_grid.CellCount());
+      ws.At(start).gScore = 0;
+      double h0 = _grid.template Cost<CostT>(_grid.PositionOf(start), goalPos, _dxCost, _dyCost).value();
+      ws.openSet.Push(start, key_t{ h0, h0 });
+
+      auto relax = [&](int from, int to, double cost) {
+        if (cost == kInf) return;
+        GridSearchWorkspace::Node &toNode = ws.At(to);
+        if (toNode.closed) return;
+        double tentative = ws.At(from).gScore + cost;
+        if (tentative < toNode.gScore) {
+          toNode.gScore = tentative;
+          toNode.parent = from;
+          double h = _grid.template Cost<CostT>(_grid.PositionOf(to), goalPos, _dxCost, _dyCost).value();
+          ws.openSet.Push(to, key_t{ tentative + h, h });
+        }
+      };
+
+      while (!ws.openSet.Empty()) {
+        int current = ws.openSet.Pop();
+        if (current == goal) {
+          abstractPath.clear();
+          for (int i = current; i >= 0; i = ws.At(i).parent) abstractPath.push_back(i);
+          std::reverse(abstractPath.begin(), abstractPath.end());
+          return true;
+        }
+
+        ws.At(current).closed = true;
+        ws.Expanded();
+        _expansions++;
+
+        int c = ClusterOf(current);
+        const Cluster &cluster = _clusters[c];
+        int local = _localIndex[current];
+        size_t n = cluster.nodes.size();
+
+        if (current == start) {
+          for (size_t j = 0; j < n; j++) relax(current, cluster.nodes[j], startCosts[j]);
+          relax(current, goal, directGoal);
+        } else if (local >= 0) {
+          for (size_t j = 0; j < n; j++) relax(current, cluster.nodes[j], cluster.dist[local * n + j]);
+          if (c == goalCluster) relax(current, goal, goalCosts[local]);
+        }
+
+        if (local >= 0) {
+          for (const Link &link : cluster.links)
+            if (link.local == local) relax(current, link.partner, link.cost);
+        }
+      }
+      return false;
+    }
+
+    // Append the cells after `from` up to and including `to`.
+    void Refine(int from, int to, std::vector<int> &cells) {
+      int c = ClusterOf(from);
+      if (c != ClusterOf(to)) {
+        cells.push_back(to);
+        return;
+      }
+
+      BoundedSearch(from, _clusters[c].box, to, _local);
+      size_t mark = cells.size();
+      for (int i = to; i != from && i >= 0; i = _local.At(i).parent) cells.push_back(i);
+      std::reverse(cells.begin() + mark, cells.end());
+    }
+
+    GridT &_grid;
+    dx_cost_t _dxCost;
+    dy_cost_t _dyCost;
+    int _clusterSize;
+
+    uint64_t _version = 0;
+    int _ccols = 0, _crows = 0;
+    std::vector<Cluster> _clusters;
+    std::vector<int> _localIndex;  // Index of a cell in its cluster's nodes, or -1.
+    std::array<double, 9> _stepCost;
+
+    GridSearchWorkspace _local, _abstract;
+    size_t _expansions = 0;
+  };
+}
@@ -0,0 +1,230 @@
+#pragma once
+
+#include "Grid.h"
+
+namespace wom {
+  /**
+   * Incremental shortest-path planner (D* Lite) bound to a DiscretisedOccupancyGrid.
+   *
+   * The search runs backwards from the goal and is kept between calls. When cells are changed
+   * through the grid's Set, only the part of the search affected by those cells is repaired, and
+   * the start may move without starting over. Changing the goal, or a Fill/FillF/Load/Reset of the
+   * grid, falls back to a full search.
+   *
+   * Paths use the same move model as DiscretisedOccupancyGrid::AStar, but plan on occupancy only:
+   * traversal costs (SetTraversalCost) are ignored.
+   */
+  template<typename GridT, typename CostT>
+  class IncrementalPlanner {
+   public:
+    using Idx_t = typename GridT::Idx_t;
+    using path_node_t = typename GridT::template GridPathNode<CostT>;
+    using dx_cost_t = typename GridT::template converting_unit<typename GridT::X_t::unit_type, CostT>;
+    using dy_cost_t = typename GridT::template converting_unit<typename GridT::Y_t::unit_type, CostT>;
+
+    IncrementalPlanner(GridT &grid, dx_cost_t dxCost, dy_cost_t dyCost)
+      : _grid(grid), _dxCost(dxCost), _dyCost(dyCost) {}
+
+    // Will plan from the closest non-obstacle nodes at the start and end.
+    std::deque<path_node_t> Plan(Idx_t start, Idx_t end) {
+      return PlanStrict(_grid.GetClosestValidNode(start), _grid.GetClosestValidNode(end));
+    }
+
+    // Will return a blank path if either the start or the end are in obstacles.
+    std::deque<path_node_t> PlanStrict(Idx_t start, Idx_t end) {
+      _expansions = 0;
+      std::deque<path_node_t> path;
+      if (_grid.Get(start) || _grid.Get(end))
+        return path;
+
+      Sync(start, end);
+      ComputeShortestPath();
+
+      if (std::isinf(_rhs[_start]))
+        return path;
+
+      // Follow the cheapest successor down the cost-to-goal field.
+      double cost = 0;
+      int current = _start;
+      path.push_back(path_node_t{ _grid.CenterOf(_grid.PositionOf(current)), units::unit_t<CostT>{cost} });
+      for (size_t steps = 0; current != _goal && steps < _g.size(); steps++) {
+        int best = -1;
+        double bestCost = 0, bestTotal = std::numeric_limits<double>::infinity();
+        ForEachSuccessor(current, [&](int succ, double c) {
+          if (c + _g[succ] < bestTotal) {
+            best = succ;
+            bestCost = c;
+            bestTotal = c + _g[succ];
+          }
+        });
+        if (best < 0)
+          return std::deque<path_node_t>{};
+
+        cost += bestCost;
+        current = best;
+        path.push_back(path_node_t{ _grid.CenterOf(_grid.PositionOf(current)), units::unit_t<CostT>{cost} });
+      }
+
+      return path;
+    }
+
+    /**
+     * Get the number of nodes expanded by the last call to Plan.
+     */
+    size_t GetExpansions() const { return _expansions; }
+
+   private:
+    using key_t = std::pair<double, double>;
+
+    // Bring the search up to date with the grid, the new start and the new end.
+    void Sync(Idx_t start, Idx_t end) {
+      int cells = (int)_grid.CellCount();
+      int startIdx = _grid.IndexOf(start), endIdx = _grid.IndexOf(end);
+
+      bool rebuild = !_initialised || cells != (int)_g.size() || endIdx != _goal;
+      if (!rebuild) {
+        if (startIdx != _start) {
+          // The start moved, so every key in the queue is now an overestimate by at most this much.
+          _km += Heuristic(_start, startIdx);
+          _start = startIdx;
+        }
+        rebuild = !_grid.ForEachChangeSince(_version, [this](Idx_t changed) { CellChanged(changed); });
+      }
+
+      if (rebuild) {
+        _start = startIdx;
+        Initialise(cells, endIdx);
+      }
+      _version = _grid.GetVersion();
+    }
+
+    void Initialise(int cells, int goal) {
+      _g.assign(cells, std::numeric_limits<double>::infinity());
+      _rhs.assign(cells, std::numeric_limits<double>::infinity());
+      _open.Resize(cells);
+      _km = 0;
+      _goal = goal;
+
+      for (int dx = -1; dx <= 1; dx++)
+        for (int dy = -1; dy <= 1; dy++)
+          _stepCost[(dx + 1) * 3 + (dy + 1)] = _grid.template Cost<CostT>(Idx_t{0, 0}, Idx_t{dx, dy}, _dxCost, _dyCost).value();
+
+      _rhs[_goal] = 0;
+      _open.Push(_goal, CalculateKey(_goal));
+      _initialised = true;
+    }
+
+    // An occupancy change alters the cost of every edge into the cell, so its neighbours' rhs.
+    void CellChanged(Idx_t cell) {
+      for (int dx = -1; dx <= 1; dx++) {
+        for (int dy = -1; dy <= 1; dy++) {
+          Idx_t pos = cell + Idx_t{ dx, dy };
+          if (!_grid.InBounds(pos)) continue;
+          int idx = _grid.IndexOf(pos);
+          if (idx != _goal)
+            _rhs[idx] = MinSuccessorCost(idx);
+          UpdateVertex(idx);
+        }
+      }
+    }
+
+    // Shrunk very slightly so that cells on an optimal path always key strictly below the start,
+    // even when rounding makes g + h come out a few ulps above the start's own cost.
+    double Heuristic(int a, int b) {
+      return _grid.template Cost<CostT>(_grid.PositionOf(a), _grid.PositionOf(b), _dxCost, _dyCost).value() * (1 - 1e-9);
+    }
+
+    key_t CalculateKey(int idx) {
+      double m = std::min(_g[idx], _rhs[idx]);
+      return key_t{ m + Heuristic(_start, idx) + _km, m };
+    }
+
+    // Calls f(neighbour, cost) for each free neighbour, which are the only cells an edge can enter.
+    template<typename F>
+    void ForEachSuccessor(int idx, F &&f) {
+      Idx_t pos = _grid.PositionOf(idx);
+      for (int dx = -1; dx <= 1; dx++) {
+        for (int dy = -1; dy <= 1; dy++) {
+          if (dx == 0 && dy == 0) continue;
+          Idx_t next = pos + Idx_t{ dx, dy };
+          if (_grid.Get(next)) continue;
+          f(_grid.IndexOf(next), _stepCost[(dx + 1) * 3 + (dy + 1)]);
+        }
+      }
+    }
+
+    // Edges are symmetric in cost but only exist into free cells, so a cell's predecessors are its
+    // neighbours if it is free, and nothing otherwise.
+    template<typename F>
+    void ForEachPredecessor(int idx, F &&f) {
+      Idx_t pos = _grid.PositionOf(idx);
+      if (_grid.Get(pos)) return;
+      for (int dx = -1; dx <= 1; dx++) {
+        for (int dy = -1; dy <= 1; dy++) {
+          if (dx == 0 && dy == 0) continue;
+          Idx_t prev = pos + Idx_t{ dx, dy };
+          if (!_grid.InBounds(prev)) continue;
+          f(_grid.IndexOf(prev), _stepCost[(dx + 1) * 3 + (dy + 1)]);
+        }
+      }
+    }
+
+    double MinSuccessorCost(int idx) {
+      double best = std::numeric_limits<double>::infinity();
+      ForEachSuccessor(idx, [&](int succ, double c) { best = std::min(best, c + _g[succ]); });
+      return best;
+    }
+
+    void UpdateVertex(int idx) {
+      if (_g[idx] != _rhs[idx])
+        _open.Push(idx, CalculateKey(idx));
+      else
+        _open.Remove(idx);
+    }
+
+    void ComputeShortestPath() {
+      while (!_open.Empty() && (_open.TopKey() < CalculateKey(_start) || _rhs[_start] != _g[_start])) {
+        int u = _open.Top();
+        key_t oldKey = _open.TopKey();
+        key_t newKey = CalculateKey(u);
+        _expansions++;
+
+        if (oldKey < newKey) {
+          _open.Update(u, newKey);
+        } else if (_g[u] > _rhs[u]) {
+          _g[u] = _rhs[u];
+          _open.Remove(u);
+          ForEachPredecessor(u, [&](int pred, double c) {
+            if (pred != _goal)
+              _rhs[pred] = std::min(_rhs[pred], c + _g[u]);
+            UpdateVertex(pred);
+          });
+        } else {
+          double gOld = _g[u];
+          _g[u] = std::numeric_limits<double>::infinity();
+          ForEachPredecessor(u, [&](int pred, double c) {
+            if (pred != _goal && _rhs[pred] == c + gOld)
+              _rhs[pred] = MinSuccessorCost(pred);
+            UpdateVertex(pred);
+          });
+          UpdateVertex(u);
+        }
+      }
+    }
+
+    GridT &_grid;
+    dx_cost_t _dxCost;
+    dy_cost_t _dyCost;
+
+    bool _initialised = false;
+    uint64_t _version = 0;
+    int _start = -1, _goal = -1;
+    double _km = 0;
+
+    std::array<double, 9> _stepCost;
+    std::vector<double> _g, _rhs;
+    detail::IndexedHeap<key_t> _open;
+
+    size_t _expansions = 0;
+  };
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace wom {
+  /**
+   * Per-cell traversal costs layered over an occupancy grid, as 8- or 16-bit integers. Entering a
+   * cell with cost c costs (1 + c * scale) times the geometric step, so costs only ever make moves
+   * dearer and geometric heuristics stay admissible.
+   *
+   * Costs come in two parts. Base costs (e.g. "avoid the charge station") are set occasionally.
+   * Transient costs (e.g. margins around defenders seen by vision) are set every tick and cleared
+   * in time proportional to the number set, rather than the size of the grid. A cell's cost is
+   * the larger of the two.
+   *
+   * Nothing is allocated until a cost is set, and a layer with every cost 0 (e.g. once transient
+   * costs are cleared) costs one branch per step.
+   */
+  template<typename T = uint8_t>
+  class TraversalCostLayer {
+   public:
+    static_assert(std::is_same_v<T, uint8_t> || std::is_same_v<T, uint16_t>, "Traversal costs are 8 or 16 bit");
+    using cost_t = T;
+
+    // Whether every cost is 0, i.e. every move costs its geometric length.
+    bool Empty() const { return _nonzero == 0; }
+
+    T Get(int idx) const { return Empty() ? T{0} : _effective[idx]; }
+
+    double Multiplier(int idx) const { return Empty() ? 1.0 : 1.0 + _scale * _effective[idx]; }
+
+    double GetScale() const { return _scale; }
+    void SetScale(double scale) {
+      // A negative scale would make costly cells cheaper than free ones, breaking the heuristics.
+      if (scale < 0)
+        throw std::invalid_argument("Traversal cost scale must be non-negative");
+      _scale = scale;
+      _version++;
+    }
+
+    // Incremented whenever any cost or the scale changes.
+    uint64_t GetVersion() const { return _version; }
+
+    void Set(size_t cells, int idx, T cost) {
+      Allocate(cells);
+      _base[idx] = cost;
+      SetEffective(idx, std::max(cost, _transient[idx]));
+      _version++;
+    }
+
+    void SetTransient(size_t cells, int idx, T cost) {
+      Allocate(cells);
+      if (_transient[idx] == 0 && cost != 0) _transientCells.push_back(idx);
+      _transient[idx] = cost;
+      SetEffective(idx, std::max(_base[idx], cost));
+      _version++;
+    }
+
+    // Reset every transient cost to 0, in O(cells set since the last clear).
+    void ClearTransient() {
+      if (_transientCells.empty()) return;
+      for (int idx : _transientCells) {
+        _transient[idx] = 0;
+        SetEffective(idx, _base[idx]);
+      }
+      _transientCells.clear();
+      _version++;
+    }
+
+    // Drop all costs, freeing the layer.
+    void Clear() {
+      _base.clear();
+      _transient.clear();
+      _effective.clear();
+      _transientCells.clear();
+      _nonzero = 0;
+      _version++;
+    }
+
+   private:
+    void Allocate(size_t cells) {
+      if (_effective.size() == cells) return;
+      _base.assign(cells, 0);
+      _transient.assign(cells, 0);
+      _effective.assign(cells, 0);
+      _transientCells.clear();
+      _nonzero = 0;
+    }
+
+    void SetEffective(int idx, T cost) {
+      _nonzero += (cost != 0) - (_effective[idx] != 0);
+      _effective[idx] = cost;
+    }
+
+    double _scale = 1.0 / 16;
+    uint64_t _version = 0;
+    std::vector<T> _base, _transient, _effective;
+    std::vector<int> _transientCells;
+    // Cells whose effective cost is nonzero.
+    size_t _nonzero = 0;
+  };
+}
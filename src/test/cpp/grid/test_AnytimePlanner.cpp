@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+
+#include "grid/AnytimePlanner.h"
+#include "GridTestUtil.h"
+
+using namespace wom;
+
+TEST(AnytimePlanner, ConvergesToAStarWithinBounds) {
+  std::mt19937 rng{4788};
+  cost_per_m_t cost{1};
+  const int size = 60;
+
+  for (int trial = 0; trial < 20; trial++) {
+    grid_t grid = RandomGrid(rng, size, 0.25);
+    auto start = RandomFreeCell(rng, grid, size), end = RandomFreeCell(rng, grid, size);
+    AnytimePlanner<grid_t, units::second> planner{ grid, cost, cost };
+
+    auto expected = grid.AStarStrict<units::second>(start, end, cost, cost);
+    path_t path;
+    for (int tick = 0; tick < 1000; tick++) {
+      path = planner.PlanStrict(start, end, (size_t)50);
+      ASSERT_LE(planner.GetExpansions(), 50u);
+      if (!path.empty()) {
+        ASSERT_EQ(grid.Discretise(path.front().position), start);
+        ASSERT_EQ(grid.Discretise(path.back().position), end);
+        ASSERT_LE(path.back().cost.value(), planner.GetEpsilon() * expected.back().cost.value() + 1e-6);
+      }
+      if (planner.IsDone()) break;
+    }
+
+    ASSERT_TRUE(planner.IsDone());
+    ASSERT_EQ(path.empty(), expected.empty());
+    if (!path.empty()) {
+      ASSERT_EQ(planner.GetEpsilon(), 1);
+      ASSERT_NEAR(path.back().cost.value(), expected.back().cost.value(), 1e-6);
+    }
+  }
+}
+
+TEST(AnytimePlanner, RestartsWhenTheGridChanges) {
+  cost_per_m_t cost{1};
+  const int size = 40;
+  grid_t grid = FieldGrid(size);
+  Eigen::Vector2i start{1, 1}, end{size - 2, size - 2};
+  AnytimePlanner<grid_t, units::second> planner{ grid, cost, cost };
+
+  planner.PlanStrict(start, end, (size_t)1000000);
+  ASSERT_TRUE(planner.IsDone());
+
+  grid.Set(Eigen::Vector2i{ size / 2, size / 2 }, !grid.Get(Eigen::Vector2i{ size / 2, size / 2 }));
+  planner.Query(start, end);
+  EXPECT_FALSE(planner.IsDone());
+  auto path = planner.PlanStrict(start, end, (size_t)1000000);
+  auto expected = grid.AStarStrict<units::second>(start, end, cost, cost);
+  ASSERT_FALSE(path.empty());
+  EXPECT_NEAR(path.back().cost.value(), expected.back().cost.value(), 1e-6);
+}
+
+TEST(AnytimePlanner, TimeBudget) {
+  cost_per_m_t cost{1};
+  const int size = 300;
+  grid_t grid = FieldGrid(size);
+  Eigen::Vector2i start{2, 2}, end{size - 3, size - 3};
+  AnytimePlanner<grid_t, units::second> planner{ grid, cost, cost };
+
+  // A 20ms robot period with a 2ms planning allowance.
+  path_t first;
+  do {
+    auto path = planner.PlanStrict(start, end, 2_ms);
+    if (first.empty()) first = path;
+  } while (!planner.IsDone());
+  auto path = planner.GetPath();
+  auto expected = grid.AStarStrict<units::second>(start, end, cost, cost);
+
+  // Early paths may be suboptimal but never better than optimal.
+  if (!first.empty()) {
+    EXPECT_GE(first.back().cost.value(), expected.back().cost.value() - 1e-6);
+  }
+  EXPECT_NEAR(path.back().cost.value(), expected.back().cost.value(), 1e-6);
+}
+
+TEST(AnytimePlanner, FoldsInTraversalCosts) {
+  std::mt19937 rng{4788};
+  cost_per_m_t cost{1};
+  const int size = 50;
+  grid_t grid = RandomGrid(rng, size, 0.15);
+  std::uniform_int_distribution<int> coord{0, size - 1}, weight{0, 255};
+  for (int i = 0; i < size * size / 3; i++)
+    grid.SetTraversalCost({ coord(rng), coord(rng) }, (uint8_t)weight(rng));
+
+  auto start = RandomFreeCell(rng, grid, size), end = RandomFreeCell(rng, grid, size);
+  AnytimePlanner<grid_t, units::second> planner{ grid, cost, cost };
+  auto path = planner.PlanStrict(start, end, (size_t)1000000);
+  auto expected = grid.AStarStrict<units::second>(start, end, cost, cost);
+  ASSERT_TRUE(planner.IsDone());
+  ASSERT_EQ(path.empty(), expected.empty());
+  if (!path.empty()) {
+    EXPECT_NEAR(path.back().cost.value(), expected.back().cost.value(), 1e-6);
+  }
+
+  // Changing a cost restarts the query.
+  grid.SetTraversalCost(start, 1);
+  planner.Query(start, end);
+  EXPECT_FALSE(planner.IsDone());
+}
@@ -0,0 +1,68 @@
+#include <gtest/gtest.h>
+
+#include "Grid.h"
+#include "GridTestUtil.h"
+
+using namespace wom;
+
+// Brute-force clearance (to occupied cells or the boundary wall) and distance to the nearest free cell.
+static void BruteForce(grid_t &grid, int size, Eigen::Vector2i cell, double &clearance, double &freeDistance) {
+  clearance = std::min({ cell.x() + 1, size - cell.x(), cell.y() + 1, size - cell.y() });
+  freeDistance = std::numeric_limits<double>::infinity();
+  for (int x = 0; x < size; x++) {
+    for (int y = 0; y < size; y++) {
+      double d = (Eigen::Vector2i{x, y} - cell).cast<double>().norm();
+      if (grid.Get({x, y})) clearance = std::min(clearance, d);
+      else freeDistance = std::min(freeDistance, d);
+    }
+  }
+}
+
+TEST(DistanceField, MatchesBruteForce) {
+  std::mt19937 rng{4788};
+  const int size = 30;
+  grid_t grid = RandomGrid(rng, size, 0.15);
+
+  std::uniform_int_distribution<int> coord{0, size - 1};
+  for (int round = 0; round < 4; round++) {
+    for (int x = 0; x < size; x++) {
+      for (int y = 0; y < size; y++) {
+        double clearance, freeDistance;
+        BruteForce(grid, size, {x, y}, clearance, freeDistance);
+        ASSERT_NEAR(grid.GetClearance({x, y}).value(), clearance, 1e-4);
+
+        Eigen::Vector2i closest = grid.GetClosestValidNode({x, y});
+        ASSERT_FALSE(grid.Get(closest));
+        ASSERT_NEAR((closest - Eigen::Vector2i{x, y}).cast<double>().norm(), freeDistance, 1e-9);
+      }
+    }
+
+    // The field must follow changes made between queries.
+    for (int i = 0; i < 10; i++) {
+      Eigen::Vector2i cell{ coord(rng), coord(rng) };
+      grid.Set(cell, !grid.Get(cell));
+    }
+  }
+}
+
+TEST(DistanceField, Inflation) {
+  grid_t grid{ 0_m, 10_m, 0_m, 10_m, 20, 20 };
+  grid.Set({10, 10}, true);
+
+  EXPECT_TRUE(grid.IsClear({10, 13}, 1_m));
+  EXPECT_FALSE(grid.IsClear({10, 12}, 1_m));
+  EXPECT_FALSE(grid.IsClear({0, 5}, 0.5_m));
+
+  auto inflated = grid.Inflated(1_m);
+  EXPECT_TRUE(inflated.Get({10, 12}));
+  EXPECT_TRUE(inflated.Get({11, 11}));
+  EXPECT_FALSE(inflated.Get({10, 13}));
+  EXPECT_FALSE(grid.Get({10, 12}));
+
+  // Paths on the inflated grid keep their distance from the obstacle.
+  cost_per_m_t cost{1};
+  auto path = inflated.AStar<units::second>({10, 5}, {10, 15}, cost, cost);
+  ASSERT_FALSE(path.empty());
+  for (auto &node : path)
+    EXPECT_TRUE(grid.IsClear(grid.Discretise(node.position), 1_m));
+}
@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+
+#include "grid/GridFile.h"
+#include "GridTestUtil.h"
+
+#include <cstring>
+#include <filesystem>
+#include <limits>
+
+using namespace wom;
+
+using packed_grid_t = DiscretisedOccupancyGrid<units::meter, units::meter, BitPackedOccupancy>;
+
+namespace {
+  std::string TempPath(const std::string &name) {
+    return (std::filesystem::temp_directory_path() / name).string();
+  }
+}
+
+TEST(GridFile, RoundTrip) {
+  std::mt19937 rng{4788};
+  grid_t grid = RandomGrid(rng, 130, 0.3);
+  grid._xmin = -1.5_m;
+  grid._ymax = 140_m;
+  Eigen::MatrixXi expected = grid._grid.ToMatrix();
+
+  for (auto encoding : { GridFileEncoding::kBitPacked, GridFileEncoding::kRLE }) {
+    std::string path = TempPath("wombat_roundtrip.grid");
+    SaveGrid(path, grid, encoding);
+
+    grid_t dense = LoadGrid<grid_t>(path);
+    packed_grid_t packed = LoadGrid<packed_grid_t>(path);
+    EXPECT_EQ(dense._grid.ToMatrix(), expected);
+    EXPECT_EQ(packed._grid.ToMatrix(), expected);
+    EXPECT_EQ(packed._grid.IsView(), encoding == GridFileEncoding::kBitPacked);
+    EXPECT_EQ(dense._xmin, -1.5_m);
+    EXPECT_EQ(packed._ymax, 140_m);
+
+    // Saving a packed grid writes its words directly, and must give the same file back.
+    std::string copyPath = TempPath("wombat_roundtrip_copy.grid");
+    SaveGrid(copyPath, packed, encoding);
+    EXPECT_EQ(LoadGrid<grid_t>(copyPath)._grid.ToMatrix(), expected);
+    std::filesystem::remove(path);
+    std::filesystem::remove(copyPath);
+  }
+}
+
+TEST(GridFile, ViewCopiesOnWrite) {
+  std::mt19937 rng{4788};
+  grid_t grid = MazeGrid(rng, 71);
+  std::string path = TempPath("wombat_view.grid");
+  SaveGrid(path, grid);
+
+  packed_grid_t a = LoadGrid<packed_grid_t>(path);
+  packed_grid_t b = a;
+  ASSERT_TRUE(b._grid.IsView());
+
+  Eigen::Vector2i cell{1, 1};
+  bool before = a.Get(cell);
+  b.Set(cell, !before);
+  EXPECT_FALSE(b._grid.IsView());
+  EXPECT_TRUE(a._grid.IsView());
+  EXPECT_EQ(a.Get(cell), before);
+  EXPECT_EQ(b.Get(cell), !before);
+  EXPECT_EQ(LoadGrid<packed_grid_t>(path).Get(cell), before);
+
+  // Views plan like any other grid.
+  cost_per_m_t cost{1};
+  EXPECT_EQ(a.AStarStrict<units::second>({1, 1}, {69, 69}, cost, cost).size(), grid.AStarStrict<units::second>({1, 1}, {69, 69}, cost, cost).size());
+  std::filesystem::remove(path);
+}
+
+TEST(GridFile, ParallelFillsOnLoadedView) {
+  std::mt19937 rng{4788};
+  grid_t grid = RandomGrid(rng, 257, 0.2);
+  std::string path = TempPath("wombat_parallel.grid");
+  SaveGrid(path, grid);
+
+  auto f = [](units::meter_t x, units::meter_t y) { return units::math::sin(x / 1_m * 1_rad) * units::math::cos(y / 1_m * 1_rad) > 0.2; };
+  auto polygons = [](auto &g) {
+    using point_t = typename std::decay_t<decltype(g)>::ContinuousIdxT;
+    return std::vector<std::vector<point_t>>{
+      { {10_m, 10_m}, {200_m, 30_m}, {120_m, 240_m} },
+      { {5_m, 250_m}, {60_m, 180_m}, {90_m, 250_m} }
+    };
+  };
+
+  ThreadPool pool{4};
+  for (int repeat = 0; repeat < 10; repeat++) {
+    packed_grid_t filled = LoadGrid<packed_grid_t>(path);
+    ASSERT_TRUE(filled._grid.IsView());
+    filled.ParallelFillF(f, pool);
+    EXPECT_FALSE(filled._grid.IsView());
+
+    packed_grid_t polygon = LoadGrid<packed_grid_t>(path);
+    polygon.FillPolygons(polygons(polygon), true, pool);
+
+    grid_t expectedFill = grid, expectedPolygon = grid;
+    expectedFill.FillF(f);
+    expectedPolygon.FillPolygons(polygons(expectedPolygon), true, pool);
+    ASSERT_EQ(filled._grid.ToMatrix(), expectedFill._grid.ToMatrix());
+    ASSERT_EQ(polygon._grid.ToMatrix(), expectedPolygon._grid.ToMatrix());
+  }
+  std::filesystem::remove(path);
+}
+
+TEST(GridFile, RejectsBadFiles) {
+  std::string path = TempPath("wombat_bad.grid");
+  {
+    std::ofstream out(path, std::ios::binary);
+    out << "not a grid file, just some text that is long enough to hold a header........";
+  }
+  EXPECT_THROW(LoadGrid<grid_t>(path), std::runtime_error);
+
+  grid_t grid = FieldGrid(50);
+  SaveGrid(path, grid, GridFileEncoding::kRLE);
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+  EXPECT_THROW(LoadGrid<grid_t>(path), std::runtime_error);
+
+  // Headers whose sizes would overflow if computed in size_t.
+  auto writeHeader = [&path](GridFileEncoding encoding, uint32_t rows, uint32_t cols, uint64_t payloadSize) {
+    GridFileHeader header{};
+    std::memcpy(header.magic, GridFileHeader::kMagic, sizeof(header.magic));
+    header.version = GridFileHeader::kVersion;
+    header.encoding = encoding;
+    header.rows = rows;
+    header.cols = cols;
+    header.xmax = header.ymax = 1;
+    header.payloadSize = payloadSize;
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write((const char *)&header, sizeof(header));
+    uint32_t run = 0;
+    for (int i = 0; i < 16; i++) out.write((const char *)&run, sizeof(run));
+  };
+  writeHeader(GridFileEncoding::kRLE, 4, 4, std::numeric_limits<uint64_t>::max() - sizeof(GridFileHeader) + 1);
+  EXPECT_THROW(LoadGrid<grid_t>(path), std::runtime_error);
+  writeHeader(GridFileEncoding::kBitPacked, 100000, 100000, 64);
+  EXPECT_THROW(LoadGrid<packed_grid_t>(path), std::runtime_error);
+
+  EXPECT_THROW(LoadGrid<grid_t>(TempPath("wombat_missing.grid")), std::runtime_error);
+  std::filesystem::remove(path);
+}
+
+TEST(GridFile, FullFieldMap) {
+  // A 2cm full field.
+  const int cols = 827, rows = 411;
+  packed_grid_t field{ 0_m, 16.54_m, 0_m, 8.21_m, (size_t)cols, (size_t)rows };
+  field.FillCircles({ { {4_m, 4_m}, 1_m }, { {12.5_m, 4_m}, 1_m } });
+  field.FillPolygon({ {7_m, 1_m}, {9.5_m, 1_m}, {9.5_m, 7_m}, {7_m, 7_m} });
+
+  for (auto encoding : { GridFileEncoding::kBitPacked, GridFileEncoding::kRLE }) {
+    std::string path = TempPath("wombat_field.grid");
+    SaveGrid(path, field, encoding);
+
+    packed_grid_t loaded = LoadGrid<packed_grid_t>(path);
+    EXPECT_EQ(loaded._grid.ToMatrix(), field._grid.ToMatrix());
+    std::filesystem::remove(path);
+  }
+}
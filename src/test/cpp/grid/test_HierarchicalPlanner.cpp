@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include "grid/HierarchicalPlanner.h"
+#include "GridTestUtil.h"
+
+using namespace wom;
+
+namespace {
+  // Checks the path is connected, avoids obstacles and joins start to end.
+  void ExpectValidPath(grid_t &grid, const path_t &path, Eigen::Vector2i start, Eigen::Vector2i end) {
+    ASSERT_FALSE(path.empty());
+    ASSERT_EQ(grid.Discretise(path.front().position), start);
+    ASSERT_EQ(grid.Discretise(path.back().position), end);
+    for (size_t i = 0; i < path.size(); i++) {
+      Eigen::Vector2i cell = grid.Discretise(path[i].position);
+      ASSERT_FALSE(grid.Get(cell));
+      if (i > 0) {
+        Eigen::Vector2i step = cell - grid.Discretise(path[i - 1].position);
+        ASSERT_LE(step.cwiseAbs().maxCoeff(), 1);
+      }
+    }
+  }
+}
+
+TEST(HierarchicalPlanner, FindsNearOptimalPathsAfterChanges) {
+  std::mt19937 rng{4788};
+  cost_per_m_t cost{1};
+  const int size = 60;
+
+  for (int trial = 0; trial < 20; trial++) {
+    grid_t grid = RandomGrid(rng, size, 0.2);
+    HierarchicalPlanner<grid_t, units::second> planner{ grid, cost, cost, 8 };
+
+    std::uniform_int_distribution<int> coord{0, size - 1};
+    for (int tick = 0; tick < 5; tick++) {
+      auto start = RandomFreeCell(rng, grid, size), end = RandomFreeCell(rng, grid, size);
+      auto path = planner.PlanStrict(start, end);
+      auto expected = grid.AStarStrict<units::second>(start, end, cost, cost);
+      ASSERT_EQ(path.empty(), expected.empty());
+      if (!path.empty()) {
+        ExpectValidPath(grid, path, start, end);
+        ASSERT_GE(path.back().cost.value(), expected.back().cost.value() - 1e-6);
+      }
+
+      for (int i = 0; i < 20; i++) {
+        Eigen::Vector2i cell{ coord(rng), coord(rng) };
+        grid.Set(cell, !grid.Get(cell));
+      }
+    }
+  }
+}
+
+TEST(HierarchicalPlanner, NearOptimalOnFieldMap) {
+  std::mt19937 rng{4788};
+  cost_per_m_t cost{1};
+  const int size = 300;
+  const int queries = 50;
+
+  grid_t grid = FieldGrid(size);
+  HierarchicalPlanner<grid_t, units::second> planner{ grid, cost, cost };
+  EXPECT_GT(planner.GetAbstractNodeCount(), 0u);
+
+  double total = 0;
+  int found = 0;
+  for (int i = 0; i < queries; i++) {
+    auto start = RandomFreeCell(rng, grid, size), end = RandomFreeCell(rng, grid, size);
+
+    auto path = planner.PlanStrict(start, end);
+    auto expected = grid.AStarStrict<units::second>(start, end, cost, cost);
+
+    ASSERT_EQ(path.empty(), expected.empty());
+    if (path.empty() || expected.back().cost.value() == 0) continue;
+    ExpectValidPath(grid, path, start, end);
+    total += path.back().cost.value() / expected.back().cost.value();
+    found++;
+  }
+  EXPECT_LT(total / found, 1.1);
+
+  // Touching one cell only rebuilds the clusters around it, and plans stay valid.
+  Eigen::Vector2i touched{ size / 2, size / 2 };
+  grid.Set(touched, !grid.Get(touched));
+  auto start = RandomFreeCell(rng, grid, size), end = RandomFreeCell(rng, grid, size);
+  auto path = planner.PlanStrict(start, end);
+  ASSERT_EQ(path.empty(), grid.AStarStrict<units::second>(start, end, cost, cost).empty());
+  if (!path.empty()) ExpectValidPath(grid, path, start, end);
+}
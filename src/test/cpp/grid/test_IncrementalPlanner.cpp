@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+
+#include "grid/IncrementalPlanner.h"
+#include "GridTestUtil.h"
+
+using namespace wom;
+
+TEST(IncrementalPlanner, MatchesAStarAfterChanges) {
+  std::mt19937 rng{4788};
+  cost_per_m_t cost{1};
+  const int size = 40;
+
+  for (int trial = 0; trial < 20; trial++) {
+    grid_t grid = RandomGrid(rng, size, 0.2);
+    auto start = RandomFreeCell(rng, grid, size), end = RandomFreeCell(rng, grid, size);
+    IncrementalPlanner<grid_t, units::second> planner{ grid, cost, cost };
+
+    std::uniform_int_distribution<int> coord{0, size - 1};
+    for (int tick = 0; tick < 10; tick++) {
+      auto path = planner.PlanStrict(start, end);
+      auto expected = grid.AStarStrict<units::second>(start, end, cost, cost);
+      ASSERT_EQ(path.empty(), expected.empty());
+      if (!path.empty()) {
+        ASSERT_NEAR(path.back().cost.value(), expected.back().cost.value(), 1e-6);
+        ASSERT_EQ(grid.Discretise(path.front().position), start);
+        ASSERT_EQ(grid.Discretise(path.back().position), end);
+      }
+
+      // Toggle a handful of cells, keeping the endpoints free, and sometimes move the start along the path.
+      for (int i = 0; i < 5; i++) {
+        Eigen::Vector2i cell{ coord(rng), coord(rng) };
+        if (cell != start && cell != end) grid.Set(cell, !grid.Get(cell));
+      }
+      if (path.size() > 2 && tick % 2)
+        start = grid.Discretise(path[1].position);
+    }
+  }
+}
+
+TEST(IncrementalPlanner, ReplanIsCheaperThanColdSearch) {
+  std::mt19937 rng{4788};
+  cost_per_m_t cost{1};
+  const int size = 150;
+
+  grid_t grid = FieldGrid(size);
+  Eigen::Vector2i start{2, 2}, end{size - 3, size - 3};
+  IncrementalPlanner<grid_t, units::second> planner{ grid, cost, cost };
+
+  planner.PlanStrict(start, end);
+  size_t cold = planner.GetExpansions();
+
+  size_t warm = 0;
+  const int ticks = 20;
+  std::uniform_int_distribution<int> coord{0, size - 1};
+  for (int tick = 0; tick < ticks; tick++) {
+    // A robot-sized blob moving around the field.
+    Eigen::Vector2i centre{ coord(rng), coord(rng) };
+    for (int dx = -1; dx <= 1; dx++)
+      for (int dy = -1; dy <= 1; dy++)
+        if (grid.InBounds(centre + Eigen::Vector2i{dx, dy})) grid.Set(centre + Eigen::Vector2i{dx, dy}, tick % 2 == 0);
+
+    auto path = planner.PlanStrict(start, end);
+    warm += planner.GetExpansions();
+
+    auto expected = grid.AStarStrict<units::second>(start, end, cost, cost);
+    ASSERT_EQ(path.empty(), expected.empty());
+    if (!path.empty()) {
+      ASSERT_NEAR(path.back().cost.value(), expected.back().cost.value(), 1e-6);
+    }
+  }
+
+  EXPECT_LT(warm / ticks, cold / 2);
+}
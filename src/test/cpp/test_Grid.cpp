@@ -5,8 +5,168 @@
 #include <units/time.h>
 
 #include "Grid.h"
+#include "GridTestUtil.h"
 
+#include <atomic>
+#include <cstdlib>
 #include <iostream>
+#include <new>
+#include <random>
+#include <thread>
+
+// Count heap allocations made by this test binary, so searches can be checked for allocation-free reuse.
+static std::atomic<size_t> g_allocations{0};
+
+void *operator new(size_t size) {
+  g_allocations++;
+  if (void *p = std::malloc(size ? size : 1))
+    return p;
+  throw std::bad_alloc{};
+}
+
+void operator delete(void *p) noexcept { std::free(p); }
+void operator delete(void *p, size_t) noexcept { std::free(p); }
+
+TEST(Grid, AStarStrictMatchesLegacy) {
+  std::mt19937 rng{4788};
+  cost_per_m_t cost{1};
+
+  for (int trial = 0; trial < 20; trial++) {
+    int size = 20 + 2 * trial;
+    grid_t grid = RandomGrid(rng, size, 0.25);
+    auto start = RandomFreeCell(rng, grid, size), end = RandomFreeCell(rng, grid, size);
+
+    path_t legacy = LegacyAStarStrict(grid, start, end, cost, cost);
+    path_t heap = grid.AStarStrict<units::second>(start, end, cost, cost);
+
+    ASSERT_EQ(legacy.empty(), heap.empty());
+    if (!heap.empty()) {
+      EXPECT_NEAR(legacy.back().cost.value(), heap.back().cost.value(), 1e-6);
+      EXPECT_EQ(grid.Discretise(heap.front().position), start);
+      EXPECT_EQ(grid.Discretise(heap.back().position), end);
+    }
+  }
+}
+
+TEST(Grid, AStarWorkspaceDoesNotAllocate) {
+  std::mt19937 rng{4788};
+  cost_per_m_t cost{1};
+  grid_t grid = RandomGrid(rng, 64, 0.2);
+
+  std::vector<std::pair<Eigen::Vector2i, Eigen::Vector2i>> queries;
+  for (int i = 0; i < 10; i++)
+    queries.emplace_back(RandomFreeCell(rng, grid, 64), RandomFreeCell(rng, grid, 64));
+
+  wom::GridSearchWorkspace workspace;
+  std::vector<grid_t::GridPathNode<units::second>> path;
+
+  // Warm up: size the workspace, heap and path to the largest query.
+  for (auto &[start, end] : queries)
+    grid.AStar<units::second>(start, end, cost, cost, workspace, path);
+
+  size_t before = g_allocations.load();
+  size_t found = 0;
+  for (int repeat = 0; repeat < 5; repeat++) {
+    for (auto &[start, end] : queries) {
+      if (grid.AStar<units::second>(start, end, cost, cost, workspace, path))
+        found++;
+    }
+  }
+  EXPECT_EQ(g_allocations.load() - before, 0u);
+  EXPECT_GT(found, 0);
+
+  // Reused workspace must give the same answer as a fresh search.
+  for (auto &[start, end] : queries) {
+    grid.AStar<units::second>(start, end, cost, cost, workspace, path);
+    auto fresh = grid.AStarStrict<units::second>(start, end, cost, cost);
+    ASSERT_EQ(path.empty(), fresh.empty());
+    if (!path.empty()) {
+      EXPECT_NEAR(path.back().cost.value(), fresh.back().cost.value(), 1e-9);
+    }
+  }
+}
+
+TEST(Grid, ConcurrentStrictSearches) {
+  std::mt19937 rng{4788};
+  cost_per_m_t cost{1};
+  grid_t grid = RandomGrid(rng, 64, 0.2);
+
+  std::vector<std::pair<Eigen::Vector2i, Eigen::Vector2i>> queries;
+  for (int i = 0; i < 16; i++)
+    queries.emplace_back(RandomFreeCell(rng, grid, 64), RandomFreeCell(rng, grid, 64));
+
+  std::vector<double> expected;
+  for (auto &[start, end] : queries) {
+    auto path = grid.AStarStrict<units::second>(start, end, cost, cost);
+    expected.push_back(path.empty() ? -1 : path.back().cost.value());
+  }
+
+  std::atomic<int> mismatches{0};
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&, t]() {
+      for (int repeat = 0; repeat < 5; repeat++) {
+        for (size_t i = 0; i < queries.size(); i++) {
+          auto &[start, end] = queries[(i + t) % queries.size()];
+          auto astar = grid.AStarStrict<units::second>(start, end, cost, cost);
+          auto jps = grid.JPSStrict<units::second>(start, end, cost, cost);
+          double want = expected[(i + t) % queries.size()];
+          if ((astar.empty() ? -1 : astar.back().cost.value()) != want) mismatches++;
+          if (std::abs((jps.empty() ? -1 : jps.back().cost.value()) - want) > 1e-6) mismatches++;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) thread.join();
+  EXPECT_EQ(mismatches, 0);
+}
+
+TEST(Grid, ConcurrentQueriesRefreshCaches) {
+  std::mt19937 rng{4788};
+  cost_per_m_t cost{1};
+  const int size = 64;
+  grid_t grid = RandomGrid(rng, size, 0.2);
+
+  // Endpoints in obstacles, so every search goes through the distance field.
+  std::vector<std::pair<Eigen::Vector2i, Eigen::Vector2i>> queries;
+  std::uniform_int_distribution<int> coord{0, size - 1};
+  while (queries.size() < 16) {
+    Eigen::Vector2i start{ coord(rng), coord(rng) }, end{ coord(rng), coord(rng) };
+    if (grid.Get(start) && grid.Get(end)) queries.emplace_back(start, end);
+  }
+  Eigen::Vector2i goal = RandomFreeCell(rng, grid, size);
+
+  for (int round = 0; round < 5; round++) {
+    // Leave the distance and cost-to-goal fields stale, so the threads race to refresh them.
+    grid.Set(RandomFreeCell(rng, grid, size), true);
+    grid_t reference = grid;
+    std::vector<double> expected, expectedToGoal;
+    for (auto &[start, end] : queries) {
+      auto path = reference.AStar<units::second>(start, end, cost, cost);
+      expected.push_back(path.empty() ? -1 : path.back().cost.value());
+      expectedToGoal.push_back(reference.CostToGoal<units::second>(reference.GetClosestValidNode(start), goal, cost, cost).value());
+    }
+
+    std::atomic<int> mismatches{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+      threads.emplace_back([&, t]() {
+        for (size_t j = 0; j < queries.size(); j++) {
+          size_t i = (j + t) % queries.size();
+          auto &[start, end] = queries[i];
+          auto astar = grid.AStar<units::second>(start, end, cost, cost);
+          if ((astar.empty() ? -1 : astar.back().cost.value()) != expected[i]) mismatches++;
+          Eigen::Vector2i from = grid.GetClosestValidNode(start);
+          if (grid.CostToGoal<units::second>(from, goal, cost, cost).value() != expectedToGoal[i]) mismatches++;
+          auto descent = grid.GoalFieldPath<units::second>(start, goal, cost, cost);
+          if (!std::isinf(expectedToGoal[i]) && std::abs(descent.back().cost.value() - expectedToGoal[i]) > 1e-6) mismatches++;
+        }
+      });
+    }
+    for (auto &thread : threads) thread.join();
+    EXPECT_EQ(mismatches, 0) << round;
+  }
+}
 
 // TEST(Grid, AStar) {
 //   Eigen::MatrixXi matrix{
@@ -35,4 +195,436 @@
 //   ASSERT_EQ(q.front(), (Eigen::Vector2i{3, 3})); q.pop_front();
 //   ASSERT_EQ(q.front(), (Eigen::Vector2i{4, 2})); q.pop_front();
 //   ASSERT_EQ(q.front(), (Eigen::Vector2i{5, 1}));
-// }
\ No newline at end of file
+// }
+TEST(Grid, BitPackedMatchesMatrix) {
+  using packed_grid_t = wom::DiscretisedOccupancyGrid<units::meter, units::meter, wom::BitPackedOccupancy>;
+
+  std::mt19937 rng{4788};
+  const int cols = 130, rows = 37;
+  Eigen::MatrixXi matrix(rows, cols);
+  std::bernoulli_distribution occupied{0.1};
+  for (int y = 0; y < rows; y++)
+    for (int x = 0; x < cols; x++)
+      matrix(y, x) = occupied(rng);
+
+  grid_t dense{ 0_m, cols * 1_m, 0_m, rows * 1_m, matrix };
+  packed_grid_t packed{ 0_m, cols * 1_m, 0_m, rows * 1_m, (size_t)cols, (size_t)rows };
+  packed.Load(matrix);
+
+  for (int y = -1; y <= rows; y++)
+    for (int x = -1; x <= cols; x++)
+      ASSERT_EQ(dense.Get({x, y}), packed.Get({x, y}));
+
+  std::uniform_int_distribution<int> cx{0, cols - 1}, cy{0, rows - 1};
+  for (int i = 0; i < 500; i++) {
+    Eigen::Vector2i a{cx(rng), cy(rng)}, b{cx(rng), (i % 2) ? a.y() : cy(rng)};
+    ASSERT_EQ(dense.AnyOccupied(a, b), packed.AnyOccupied(a, b));
+  }
+
+  cost_per_m_t cost{1};
+  auto densePath = dense.AStar<units::second>({0, 0}, {cols - 1, rows - 1}, cost, cost);
+  auto packedPath = packed.AStar<units::second>({0, 0}, {cols - 1, rows - 1}, cost, cost);
+  ASSERT_EQ(densePath.size(), packedPath.size());
+  EXPECT_NEAR(densePath.back().cost.value(), packedPath.back().cost.value(), 1e-9);
+
+  packed.Fill(true);
+  EXPECT_TRUE(packed.Get({cols - 1, rows - 1}));
+  packed.FillF([](units::meter_t x, units::meter_t y) { return x > 100_m; });
+  EXPECT_FALSE(packed.AnyOccupied({0, 0}, {99, rows - 1}));
+  EXPECT_TRUE(packed.AnyOccupied({100, 0}, {cols - 1, 0}));
+  packed.Set({3, 3}, true);
+  EXPECT_TRUE(packed.Get({3, 3}));
+}
+
+
+TEST(Grid, JPSMatchesAStar) {
+  std::mt19937 rng{4788};
+  cost_per_m_t xcost{1}, ycost{1.7};
+
+  wom::GridSearchWorkspace workspace;
+  std::vector<grid_t::GridPathNode<units::second>> astarPath, jpsPath;
+  for (int trial = 0; trial < 200; trial++) {
+    int size = 10 + trial % 30;
+    grid_t grid = RandomGrid(rng, size, 0.05 * (trial % 8));
+    auto start = RandomFreeCell(rng, grid, size), end = RandomFreeCell(rng, grid, size);
+
+    bool astarFound = grid.AStarStrict<units::second>(start, end, xcost, ycost, workspace, astarPath);
+    bool jpsFound = grid.JPSStrict<units::second>(start, end, xcost, ycost, workspace, jpsPath);
+    ASSERT_EQ(astarFound, jpsFound);
+    if (!jpsFound) continue;
+
+    ASSERT_NEAR(astarPath.back().cost.value(), jpsPath.back().cost.value(), 1e-6);
+    ASSERT_EQ(grid.Discretise(jpsPath.front().position), start);
+    for (size_t i = 1; i < jpsPath.size(); i++) {
+      Eigen::Vector2i a = grid.Discretise(jpsPath[i - 1].position), b = grid.Discretise(jpsPath[i].position);
+      ASSERT_LE((b - a).cwiseAbs().maxCoeff(), 1);
+      ASSERT_FALSE(grid.Get(b));
+    }
+  }
+}
+
+TEST(Grid, JPSExpandsFewerNodes) {
+  std::mt19937 rng{4788};
+  cost_per_m_t cost{1};
+  const int size = 201;
+
+  // Open maps should need an order of magnitude fewer expansions. A maze has a jump point at
+  // nearly every junction, so it only needs to do better at all.
+  struct Case {
+    std::string name;
+    grid_t grid;
+    size_t minReduction;
+  };
+  std::vector<Case> cases{
+    { "empty", grid_t{ 0_m, size * 1_m, 0_m, size * 1_m, (size_t)size, (size_t)size }, 10 },
+    { "maze", MazeGrid(rng, size), 2 },
+    { "field", FieldGrid(size), 10 }
+  };
+
+  wom::GridSearchWorkspace workspace;
+  std::vector<grid_t::GridPathNode<units::second>> path;
+  for (auto &[name, grid, minReduction] : cases) {
+    Eigen::Vector2i start{1, 1}, end{size - 2, size - 2};
+
+    ASSERT_TRUE(grid.AStarStrict<units::second>(start, end, cost, cost, workspace, path)) << name;
+    size_t astarExpansions = workspace.GetExpansions();
+    double astarCost = path.back().cost.value();
+
+    ASSERT_TRUE(grid.JPSStrict<units::second>(start, end, cost, cost, workspace, path)) << name;
+    size_t jpsExpansions = workspace.GetExpansions();
+
+    EXPECT_NEAR(astarCost, path.back().cost.value(), 1e-6) << name;
+    EXPECT_LT(jpsExpansions * minReduction, astarExpansions) << name;
+  }
+}
+
+TEST(Grid, LineOfSightMatchesStorages) {
+  using packed_grid_t = wom::DiscretisedOccupancyGrid<units::meter, units::meter, wom::BitPackedOccupancy>;
+  std::mt19937 rng{4788};
+  const int size = 70;
+
+  grid_t grid = RandomGrid(rng, size, 0.05);
+  packed_grid_t packed{ 0_m, size * 1_m, 0_m, size * 1_m, grid._grid.ToMatrix() };
+  std::uniform_int_distribution<int> coord{0, size - 1};
+  for (int i = 0; i < 20000; i++) {
+    Eigen::Vector2i a{ coord(rng), coord(rng) }, b{ coord(rng), coord(rng) };
+    bool visible = grid.LineOfSight(a, b);
+    ASSERT_EQ(visible, grid.LineOfSight(b, a));
+    ASSERT_EQ(visible, packed.LineOfSight(a, b));
+    if (visible) {
+      ASSERT_FALSE(grid.Get(a));
+      ASSERT_FALSE(grid.Get(b));
+    }
+    // Neighbours always see each other, as A* may step between them.
+    Eigen::Vector2i n = a + Eigen::Vector2i{ coord(rng) % 3 - 1, coord(rng) % 3 - 1 };
+    if (grid.InBounds(n) && !grid.Get(a) && !grid.Get(n)) {
+      ASSERT_TRUE(grid.LineOfSight(a, n));
+    }
+  }
+}
+
+TEST(Grid, ThetaStarAndShortcut) {
+  std::mt19937 rng{4788};
+  cost_per_m_t cost{1};
+  const int size = 201;
+
+  std::vector<std::pair<std::string, grid_t>> grids{
+    { "random", RandomGrid(rng, size, 0.2) },
+    { "maze", MazeGrid(rng, size) },
+    { "field", FieldGrid(size) }
+  };
+
+  auto expectVisible = [](grid_t &grid, const path_t &path) {
+    for (size_t i = 1; i < path.size(); i++)
+      ASSERT_TRUE(grid.LineOfSight(grid.Discretise(path[i - 1].position), grid.Discretise(path[i].position)));
+  };
+
+  for (auto &[name, grid] : grids) {
+    Eigen::Vector2i start = RandomFreeCell(rng, grid, size), end = RandomFreeCell(rng, grid, size);
+    if (name != "random") {
+      start = {1, 1};
+      end = {size - 2, size - 2};
+    }
+
+    auto astar = grid.AStarStrict<units::second>(start, end, cost, cost);
+    auto theta = grid.ThetaStarStrict<units::second>(start, end, cost, cost);
+    auto shortcut = grid.Shortcut<units::second>(astar, cost, cost);
+
+    ASSERT_FALSE(astar.empty()) << name;
+    ASSERT_FALSE(theta.empty()) << name;
+    EXPECT_EQ(grid.Discretise(theta.front().position), start);
+    EXPECT_EQ(grid.Discretise(theta.back().position), end);
+    EXPECT_EQ(grid.Discretise(shortcut.back().position), end);
+    expectVisible(grid, theta);
+    expectVisible(grid, shortcut);
+    EXPECT_LE(theta.back().cost.value(), astar.back().cost.value() * 1.01) << name;
+    EXPECT_LE(shortcut.back().cost.value(), astar.back().cost.value() + 1e-6) << name;
+    EXPECT_LT(theta.size(), astar.size()) << name;
+    EXPECT_LT(shortcut.size(), astar.size()) << name;
+  }
+}
+
+TEST(Grid, GoalFieldMatchesAStar) {
+  std::mt19937 rng{4788};
+  cost_per_m_t cost{1};
+  const int size = 150;
+
+  grid_t grid = RandomGrid(rng, size, 0.25);
+  Eigen::Vector2i goal = RandomFreeCell(rng, grid, size);
+
+  const int starts = 100;
+  for (int i = 0; i < starts; i++) {
+    // Change the grid halfway through, which must invalidate the cached field.
+    if (i == starts / 2) {
+      for (int j = 0; j < 200; j++) {
+        Eigen::Vector2i cell = RandomFreeCell(rng, grid, size);
+        if (cell != goal) grid.Set(cell, true);
+      }
+    }
+
+    Eigen::Vector2i start = RandomFreeCell(rng, grid, size);
+    auto expected = grid.AStarStrict<units::second>(start, goal, cost, cost);
+    auto path = grid.GoalFieldPathStrict<units::second>(start, goal, cost, cost);
+
+    ASSERT_EQ(path.empty(), expected.empty());
+    if (path.empty()) {
+      EXPECT_TRUE(std::isinf(grid.CostToGoal<units::second>(start, goal, cost, cost).value()));
+      continue;
+    }
+    ASSERT_NEAR(path.back().cost.value(), expected.back().cost.value(), 1e-6);
+    ASSERT_NEAR(grid.CostToGoal<units::second>(start, goal, cost, cost).value(), expected.back().cost.value(), 1e-6);
+    ASSERT_EQ(grid.Discretise(path.front().position), start);
+    ASSERT_EQ(grid.Discretise(path.back().position), goal);
+    for (size_t j = 1; j < path.size(); j++) {
+      Eigen::Vector2i step = grid.Discretise(path[j].position) - grid.Discretise(path[j - 1].position);
+      ASSERT_LE(step.cwiseAbs().maxCoeff(), 1);
+      ASSERT_FALSE(grid.Get(grid.Discretise(path[j].position)));
+    }
+  }
+}
+
+TEST(Grid, ParallelFillMatchesFillF) {
+  using packed_grid_t = wom::DiscretisedOccupancyGrid<units::meter, units::meter, wom::BitPackedOccupancy>;
+  const int cols = 331, rows = 163;
+  auto f = [](units::meter_t x, units::meter_t y) { return units::math::sin(x / 1_m * 1_rad) * units::math::cos(y / 1_m * 1_rad) > 0.2; };
+
+  grid_t serial{ 0_m, 16.54_m, 0_m, 8.21_m, (size_t)cols, (size_t)rows };
+  grid_t parallel = serial;
+  packed_grid_t packed{ 0_m, 16.54_m, 0_m, 8.21_m, (size_t)cols, (size_t)rows };
+
+  serial.FillF(f);
+  parallel.ParallelFillF(f);
+  wom::ThreadPool pool{4};
+  packed.ParallelFillF(f, pool);
+
+  EXPECT_EQ(serial._grid.ToMatrix(), parallel._grid.ToMatrix());
+  EXPECT_EQ(serial._grid.ToMatrix(), packed._grid.ToMatrix());
+}
+
+TEST(Grid, FillPolygonsAndCircles) {
+  using packed_grid_t = wom::DiscretisedOccupancyGrid<units::meter, units::meter, wom::BitPackedOccupancy>;
+  using point_t = grid_t::ContinuousIdxT;
+  const int cols = 197, rows = 143;
+
+  std::vector<std::vector<point_t>> polygons{
+    { {1_m, 1_m}, {8_m, 2_m}, {5_m, 7_m} },
+    { {10_m, 1_m}, {19_m, 1_m}, {19_m, 9_m}, {15_m, 4_m}, {10_m, 9_m} },
+    { {2_m, 10_m}, {9_m, 10_m}, {9_m, 14_m}, {2_m, 14_m} }
+  };
+  std::vector<grid_t::Circle> circles{ { {14_m, 12_m}, 2.5_m }, { {0_m, 15_m}, 3_m } };
+
+  // Brute force: test every cell centre against every shape.
+  auto insidePolygon = [](const std::vector<point_t> &p, units::meter_t x, units::meter_t y) {
+    bool inside = false;
+    for (size_t i = 0, j = p.size() - 1; i < p.size(); j = i++)
+      if ((p[i].y <= y) != (p[j].y <= y) && x < p[i].x + (p[j].x - p[i].x) * ((y - p[i].y) / (p[j].y - p[i].y)))
+        inside = !inside;
+    return inside;
+  };
+  grid_t expected{ 0_m, 20_m, 0_m, 15_m, (size_t)cols, (size_t)rows };
+  expected.FillF([&](units::meter_t x, units::meter_t y) {
+    for (auto &p : polygons)
+      if (insidePolygon(p, x, y)) return true;
+    for (auto &c : circles)
+      if (units::math::hypot(x - c.centre.x, y - c.centre.y) <= c.radius) return true;
+    return false;
+  });
+
+  grid_t dense{ 0_m, 20_m, 0_m, 15_m, (size_t)cols, (size_t)rows };
+  packed_grid_t packed{ 0_m, 20_m, 0_m, 15_m, (size_t)cols, (size_t)rows };
+  dense.FillPolygons(polygons);
+  dense.FillCircles(circles);
+  for (auto &p : polygons) {
+    std::vector<packed_grid_t::ContinuousIdxT> vertices;
+    for (auto &v : p) vertices.push_back({ v.x, v.y });
+    packed.FillPolygon(vertices);
+  }
+  for (auto &c : circles) packed.FillCircle({ c.centre.x, c.centre.y }, c.radius);
+
+  // Cells whose centre lies exactly on an edge may go either way.
+  Eigen::MatrixXi diff = (dense._grid.ToMatrix() - expected._grid.ToMatrix()).cwiseAbs();
+  EXPECT_LE(diff.sum(), cols / 20);
+  EXPECT_EQ(dense._grid.ToMatrix(), packed._grid.ToMatrix());
+
+  // Clearing a shape leaves the rest alone.
+  dense.FillCircles(circles, false);
+  EXPECT_FALSE(dense.Get(dense.Discretise(circles[0].centre)));
+  EXPECT_TRUE(dense.Get(dense.Discretise(point_t{ 5_m, 12_m })));
+}
+
+TEST(Grid, AStarBatchMatchesSerial) {
+  std::mt19937 rng{4788};
+  cost_per_m_t cost{1};
+  const int size = 150;
+  grid_t grid = RandomGrid(rng, size, 0.25);
+
+  std::vector<std::pair<Eigen::Vector2i, Eigen::Vector2i>> queries;
+  std::uniform_int_distribution<int> coord{0, size - 1};
+  for (int i = 0; i < 64; i++) {
+    // Some endpoints land in obstacles, which AStarBatch moves and AStarBatchStrict rejects.
+    queries.emplace_back(Eigen::Vector2i{ coord(rng), coord(rng) }, Eigen::Vector2i{ coord(rng), coord(rng) });
+  }
+
+  std::vector<path_t> serial, serialStrict;
+  for (auto &[start, end] : queries) {
+    serial.push_back(grid.AStar<units::second>(start, end, cost, cost));
+    serialStrict.push_back(grid.AStarStrict<units::second>(start, end, cost, cost));
+  }
+
+  wom::ThreadPool pool{4};
+  auto batch = grid.AStarBatch<units::second>(queries, cost, cost, pool);
+  auto batchStrict = grid.AStarBatchStrict<units::second>(queries, cost, cost, pool);
+
+  ASSERT_EQ(batch.size(), queries.size());
+  ASSERT_EQ(batchStrict.size(), queries.size());
+  for (size_t i = 0; i < queries.size(); i++) {
+    ASSERT_EQ(batch[i].size(), serial[i].size()) << i;
+    ASSERT_EQ(batchStrict[i].size(), serialStrict[i].size()) << i;
+    if (!batch[i].empty()) {
+      EXPECT_NEAR(batch[i].back().cost.value(), serial[i].back().cost.value(), 1e-6);
+    }
+  }
+}
+
+TEST(Grid, AStarBatchInsidePoolJobs) {
+  std::mt19937 rng{4788};
+  cost_per_m_t cost{1};
+  const int size = 40;
+  grid_t grid = RandomGrid(rng, size, 0.2);
+
+  std::vector<std::pair<Eigen::Vector2i, Eigen::Vector2i>> queries;
+  for (int i = 0; i < 8; i++)
+    queries.emplace_back(RandomFreeCell(rng, grid, size), RandomFreeCell(rng, grid, size));
+  auto expected = grid.AStarBatchStrict<units::second>(queries, cost, cost, wom::ThreadPool::Global());
+
+  // One thread batches on the pool while pool jobs batch on the same grid. Holding the grid's
+  // workspaces across the dispatch would deadlock here.
+  wom::ThreadPool pool{2};
+  std::thread other([&]() {
+    for (int i = 0; i < 50; i++) grid.AStarBatchStrict<units::second>(queries, cost, cost, pool);
+  });
+  std::atomic<int> mismatches{0};
+  for (int i = 0; i < 50; i++) {
+    pool.ParallelFor(4, [&](size_t) {
+      auto paths = grid.AStarBatchStrict<units::second>(queries, cost, cost, pool);
+      for (size_t q = 0; q < queries.size(); q++)
+        if (paths[q].size() != expected[q].size()) mismatches++;
+    });
+  }
+  other.join();
+  EXPECT_EQ(mismatches, 0);
+}
+
+TEST(Grid, TraversalCosts) {
+  std::mt19937 rng{4788};
+  cost_per_m_t cost{1};
+  const int size = 80;
+
+  for (int trial = 0; trial < 10; trial++) {
+    grid_t grid = RandomGrid(rng, size, 0.15);
+    std::uniform_int_distribution<int> coord{0, size - 1}, weight{0, 255};
+    for (int i = 0; i < size * size / 3; i++)
+      grid.SetTraversalCost({ coord(rng), coord(rng) }, (uint8_t)weight(rng));
+
+    Eigen::Vector2i start = RandomFreeCell(rng, grid, size), end = RandomFreeCell(rng, grid, size);
+    auto astar = grid.AStarStrict<units::second>(start, end, cost, cost);
+    if (astar.empty()) continue;
+
+    // Forward A*, the reverse Dijkstra field and JPS (falling back to A*) must agree on the optimum.
+    double optimal = astar.back().cost.value();
+    EXPECT_NEAR(grid.GoalFieldPathStrict<units::second>(start, end, cost, cost).back().cost.value(), optimal, 1e-6);
+    EXPECT_NEAR(grid.CostToGoal<units::second>(start, end, cost, cost).value(), optimal, 1e-6);
+    EXPECT_NEAR(grid.JPSStrict<units::second>(start, end, cost, cost).back().cost.value(), optimal, 1e-6);
+
+    // Costs only make moves dearer.
+    grid_t plain = grid;
+    plain.ClearTraversalCosts();
+    EXPECT_GE(optimal, plain.AStarStrict<units::second>(start, end, cost, cost).back().cost.value() - 1e-6);
+
+    auto theta = grid.ThetaStarStrict<units::second>(start, end, cost, cost);
+    // Theta* only shortcuts through zero-cost cells, so it is not bounded by the weighted optimum.
+    ASSERT_FALSE(theta.empty());
+    EXPECT_EQ(grid.Discretise(theta.back().position), end);
+    auto shortcut = grid.Shortcut<units::second>(astar, cost, cost);
+    EXPECT_LE(shortcut.back().cost.value(), optimal + 1e-6);
+  }
+}
+
+TEST(Grid, TransientTraversalCosts) {
+  cost_per_m_t cost{1};
+  const int size = 100;
+  grid_t grid{ 0_m, size * 1_m, 0_m, size * 1_m, (size_t)size, (size_t)size };
+  Eigen::Vector2i start{10, 50}, end{90, 50};
+
+  auto straight = grid.AStarStrict<units::second>(start, end, cost, cost);
+  uint64_t version = grid.GetTraversalVersion();
+
+  // A defender in the way, with a soft margin: the path goes around it, but does not have to.
+  for (int x = 45; x <= 55; x++)
+    for (int y = 35; y <= 65; y++)
+      grid.SetTransientTraversalCost({ x, y }, 200);
+  EXPECT_NE(grid.GetTraversalVersion(), version);
+
+  auto around = grid.AStarStrict<units::second>(start, end, cost, cost);
+  ASSERT_FALSE(around.empty());
+  for (auto &node : around)
+    EXPECT_EQ(grid.GetTraversalCost(grid.Discretise(node.position)), 0);
+  EXPECT_GT(around.back().cost.value(), straight.back().cost.value());
+
+  // Walled in, the costly cells are crossed rather than failing.
+  for (int x = 45; x <= 55; x++) {
+    grid.Set({ x, 34 }, true);
+    grid.Set({ x, 66 }, true);
+  }
+  for (int y = 0; y < size; y++)
+    if (y < 34 || y > 66) grid.Set({ 50, y }, true);
+  EXPECT_FALSE(grid.AStarStrict<units::second>(start, end, cost, cost).empty());
+
+  // Clearing restores the base costs, and with none left JPS jumps again rather than falling back
+  // to A*.
+  grid.ClearTransientTraversalCosts();
+  EXPECT_EQ(grid.GetTraversalCost({ 50, 50 }), 0);
+  wom::GridSearchWorkspace workspace;
+  std::vector<grid_t::GridPathNode<units::second>> path;
+  ASSERT_TRUE(grid.AStarStrict<units::second>(start, end, cost, cost, workspace, path));
+  size_t astarExpansions = workspace.GetExpansions();
+  ASSERT_TRUE(grid.JPSStrict<units::second>(start, end, cost, cost, workspace, path));
+  EXPECT_LT(workspace.GetExpansions() * 2, astarExpansions);
+
+  EXPECT_THROW(grid.SetTraversalScale(-1), std::invalid_argument);
+
+  grid.SetTraversalCost({ 50, 50 }, 10);
+  grid.SetTransientTraversalCost({ 50, 50 }, 100);
+  EXPECT_EQ(grid.GetTraversalCost({ 50, 50 }), 100);
+  grid.ClearTransientTraversalCosts();
+  EXPECT_EQ(grid.GetTraversalCost({ 50, 50 }), 10);
+
+  // Out of bounds cells are ignored, rather than wrapping onto the next row.
+  version = grid.GetTraversalVersion();
+  grid.SetTraversalCost({ size, 0 }, 50);
+  grid.SetTransientTraversalCost({ -1, 1 }, 50);
+  EXPECT_EQ(grid.GetTraversalVersion(), version);
+  EXPECT_EQ(grid.GetTraversalCost({ 0, 1 }), 0);
+  EXPECT_EQ(grid.GetTraversalCost({ size - 1, 0 }), 0);
+  EXPECT_EQ(grid.GetTraversalCost({ size, 0 }), 0);
+}
@@ -4,6 +4,8 @@
 
 #include <units/length.h>
 
+#include <cmath>
+
 using namespace wom;
 
 TEST(LUT, NoPoints) {
@@ -55,4 +57,108 @@ TEST(LUT, AtAPoint) {
         {21, 300}
     });
     EXPECT_NEAR(lut.Estimate(16), 7.1, 0.001);
-}
\ No newline at end of file
+}
+TEST(LUT, ModesAgree) {
+    std::vector<LUTPoint<double, double>> points{
+        {1, 9},
+        {5, 12.8},
+        {16, 7.1},
+        {16, 8},
+        {21, 3}
+    };
+    LUT<double, double> scan(points, LUTMode::kLinearScan), binary(points, LUTMode::kBinarySearch);
+    LUT<double, double> uniform(points, LUTMode::kUniform, LUT<double, double>::kMaxUniformSamples);
+
+    for (double x = -2; x <= 24; x += 0.01) {
+        EXPECT_NEAR(binary.Estimate(x), scan.Estimate(x), 1e-9) << x;
+        // Resampling rounds off the step at x = 16 over one sample.
+        if (std::abs(x - 16) > 0.01) EXPECT_NEAR(uniform.Estimate(x), scan.Estimate(x), 1e-6) << x;
+    }
+    EXPECT_NEAR(uniform.Estimate(0.3), 9, 0.001);
+    EXPECT_NEAR(uniform.Estimate(314159265359), 3, 0.001);
+}
+
+TEST(LUT, UniformIsExactOnEvenlySpacedPoints) {
+    LUT<units::meter_t, units::meter_t> lut({
+        {0_m, 1_m},
+        {0.5_m, 3_m},
+        {1_m, 2_m},
+        {1.5_m, -1_m}
+    }, LUTMode::kUniform);
+    EXPECT_NEAR(lut.Estimate(0.25_m).value(), 2, 1e-9);
+    EXPECT_NEAR(lut.Estimate(1_m).value(), 2, 1e-9);
+    EXPECT_NEAR(lut.Estimate(1.4_m).value(), -0.4, 1e-9);
+    EXPECT_NEAR(lut.Estimate(1.5_m).value(), -1, 1e-9);
+    EXPECT_NEAR(lut.Estimate(-1_m).value(), 1, 1e-9);
+    EXPECT_NEAR(lut.Estimate(3_m).value(), -1, 1e-9);
+}
+
+TEST(LUT, StaticMatchesDynamic) {
+    static constexpr StaticLUT<double, double, 5> table{{{
+        {1, 9},
+        {5, 12.8},
+        {16, 7.1},
+        {16, 8},
+        {21, 3}
+    }}};
+    static_assert(table.Estimate(0.3) == 9);
+    static_assert(table.Estimate(3) > 10.899 && table.Estimate(3) < 10.901);
+    static_assert(table.Estimate(100) == 3);
+
+    LUT<double, double> lut({ table.GetPoints().begin(), table.GetPoints().end() });
+    for (double x = -2; x <= 24; x += 0.01)
+        EXPECT_NEAR(table.Estimate(x), lut.Estimate(x), 1e-9) << x;
+
+    constexpr StaticLUT<units::meter_t, units::meter_t, 1> single{{{ {1_m, 9_m} }}};
+    EXPECT_NEAR(single.Estimate(3_m).value(), 9, 0.001);
+
+    // Not constexpr, but still built during compilation.
+    auto made = MakeStaticLUT<double, double>({ {1, 9}, {5, 12.8}, {16, 7.1}, {16, 8}, {21, 3} });
+    for (double x = -2; x <= 24; x += 0.01)
+        EXPECT_EQ(made.Estimate(x), table.Estimate(x)) << x;
+}
+
+TEST(LUT, StaticRejectsUnsortedPoints) {
+    static_assert(!StaticLUT<double, double, 2>::IsSorted({{ {2, 0}, {1, 0} }}));
+    // Built at runtime, the check throws. MakeStaticLUT<double, double>({ {2, 0}, {1, 0} }) would
+    // not compile.
+    EXPECT_THROW((StaticLUT<double, double, 2>{{{ {2, 0}, {1, 0} }}}), std::invalid_argument);
+}
+
+TEST(LUT, MonotoneCubic) {
+    std::vector<LUTPoint<double, double>> points{
+        {1, 9},
+        {5, 12.8},
+        {6, 12.9},
+        {16, 7.1},
+        {21, 3},
+        {22, 3}
+    };
+    LUT<double, double> linear(points), cubic(points, LUTMode::kMonotoneCubic);
+
+    // Passes through the points, clamps like the linear modes, and stays within each segment's ends.
+    for (auto &p : points) EXPECT_NEAR(cubic.Estimate(p.x), p.y, 1e-9);
+    EXPECT_NEAR(cubic.Estimate(0.3), 9, 1e-9);
+    EXPECT_NEAR(cubic.Estimate(314159265359), 3, 1e-9);
+    for (size_t i = 1; i < points.size(); i++) {
+        double lo = std::min(points[i - 1].y, points[i].y), hi = std::max(points[i - 1].y, points[i].y);
+        for (double x = points[i - 1].x; x <= points[i].x; x += 0.01) {
+            EXPECT_GE(cubic.Estimate(x), lo - 1e-9) << x;
+            EXPECT_LE(cubic.Estimate(x), hi + 1e-9) << x;
+        }
+    }
+
+    // The slope is continuous at the points, where the linear one jumps.
+    double h = 1e-6;
+    for (double x : { 5.0, 6.0, 16.0 }) {
+        double left = (cubic.Estimate(x) - cubic.Estimate(x - h)) / h, right = (cubic.Estimate(x + h) - cubic.Estimate(x)) / h;
+        EXPECT_NEAR(left, right, 1e-4) << x;
+    }
+    EXPECT_GT(std::abs((linear.Estimate(5 + h) - linear.Estimate(5)) / h - (linear.Estimate(5) - linear.Estimate(5 - h)) / h), 0.5);
+
+    // Typed, with a step at a repeated x.
+    LUT<units::meter_t, units::meter_t> typed({ {0_m, 0_m}, {1_m, 1_m}, {1_m, 2_m}, {2_m, 3_m} }, LUTMode::kMonotoneCubic);
+    EXPECT_NEAR(typed.Estimate(0.5_m).value(), 0.5, 1e-9);
+    EXPECT_NEAR(typed.Estimate(1_m).value(), 1, 1e-9);
+    EXPECT_NEAR(typed.Estimate(1.5_m).value(), 2.5, 1e-9);
+}
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include "LUT2D.h"
+
+#include <units/angle.h>
+#include <units/length.h>
+#include <units/velocity.h>
+
+#include <cmath>
+#include <random>
+
+using namespace wom;
+
+template<typename F>
+static std::vector<double> Sample(const std::vector<double> &xs, const std::vector<double> &ys, F f) {
+  std::vector<double> values;
+  for (double y : ys)
+    for (double x : xs) values.push_back(f(x, y));
+  return values;
+}
+
+TEST(LUT2D, BilinearIsExactForBilinearFunctions) {
+  auto f = [](double x, double y) { return 3 + 2 * x - y + 0.5 * x * y; };
+  std::vector<double> xs{ 0, 1, 2.5, 4, 7 }, ys{ -1, 0, 1, 2 };
+  LUT2D<double, double, double> lut(xs, ys, Sample(xs, ys, f));
+  EXPECT_FALSE(lut.GetXAxis().IsUniform());
+  EXPECT_TRUE(lut.GetYAxis().IsUniform());
+
+  std::mt19937 rng{4788};
+  std::uniform_real_distribution<double> x{0, 7}, y{-1, 2};
+  for (int i = 0; i < 1000; i++) {
+    double qx = x(rng), qy = y(rng);
+    EXPECT_NEAR(lut.Estimate(qx, qy), f(qx, qy), 1e-9);
+  }
+
+  // Clamped to the edges outside the grid.
+  EXPECT_NEAR(lut.Estimate(-5, 1.5), f(0, 1.5), 1e-9);
+  EXPECT_NEAR(lut.Estimate(3, 10), f(3, 2), 1e-9);
+  EXPECT_NEAR(lut.Estimate(100, -100), f(7, -1), 1e-9);
+}
+
+TEST(LUT2D, BicubicIsSmootherAndExactForQuadratics) {
+  std::vector<double> xs, ys;
+  for (int i = 0; i <= 10; i++) xs.push_back(i * 0.5);
+  for (int i = 0; i <= 8; i++) ys.push_back(-1 + i * 0.25);
+
+  // Catmull-Rom tangents are exact for quadratics on evenly spaced knots, away from the one-sided ends.
+  auto quadratic = [](double x, double y) { return 1 + x * x - 2 * x * y + 0.3 * y * y; };
+  LUT2D<double, double, double> cubic(xs, ys, Sample(xs, ys, quadratic), LUT2DInterpolation::kBicubic);
+  for (double x = 0.5; x <= 4.5; x += 0.05)
+    for (double y = -0.75; y <= 0.75; y += 0.05)
+      EXPECT_NEAR(cubic.Estimate(x, y), quadratic(x, y), 1e-9) << x << ", " << y;
+
+  auto smooth = [](double x, double y) { return std::sin(x) * std::cos(2 * y); };
+  LUT2D<double, double, double> linearSmooth(xs, ys, Sample(xs, ys, smooth)), cubicSmooth(xs, ys, Sample(xs, ys, smooth), LUT2DInterpolation::kBicubic);
+  double linearError = 0, cubicError = 0;
+  for (double x = 0; x <= 5; x += 0.01) {
+    for (double y = -1; y <= 1; y += 0.01) {
+      linearError = std::max(linearError, std::abs(linearSmooth.Estimate(x, y) - smooth(x, y)));
+      cubicError = std::max(cubicError, std::abs(cubicSmooth.Estimate(x, y) - smooth(x, y)));
+    }
+  }
+  EXPECT_LT(cubicError, linearError / 2);
+
+  // Both pass through the knots.
+  for (double x : xs)
+    for (double y : ys) EXPECT_NEAR(cubicSmooth.Estimate(x, y), smooth(x, y), 1e-12);
+}
+
+TEST(LUT2D, UnitsAndBatches) {
+  LUT2D<units::meter_t, units::radian_t, units::meters_per_second_t> lut(
+    { 1_m, 2_m, 4_m }, { 0_rad, 0.5_rad }, { 10_mps, 12_mps, 16_mps, 11_mps, 13_mps, 17_mps });
+  EXPECT_NEAR(lut.Estimate(3_m, 0.25_rad).value(), 14.5, 1e-9);
+
+  std::vector<units::meter_t> xs{ 0_m, 1.5_m, 3_m, 9_m };
+  std::vector<units::radian_t> ys{ 0_rad, 0.5_rad, 0.25_rad, 1_rad };
+  std::vector<units::meters_per_second_t> out(xs.size());
+  lut.Estimate(xs, ys, out);
+  for (size_t k = 0; k < xs.size(); k++)
+    EXPECT_NEAR(out[k].value(), lut.Estimate(xs[k], ys[k]).value(), 1e-12);
+
+  out.pop_back();
+  EXPECT_THROW(lut.Estimate(xs, ys, out), std::invalid_argument);
+}
+
+TEST(LUT2D, RejectsBadTables) {
+  EXPECT_THROW((LUT2D<double, double, double>({ 0, 1 }, { 0, 1 }, { 1, 2, 3 })), std::invalid_argument);
+  EXPECT_THROW((LUT2D<double, double, double>({ 0 }, { 0, 1 }, { 1, 2 })), std::invalid_argument);
+  EXPECT_THROW((LUT2D<double, double, double>({ 1, 0 }, { 0, 1 }, { 1, 2, 3, 4 })), std::invalid_argument);
+}
@@ -0,0 +1,106 @@
+#include <gtest/gtest.h>
+
+#include "LiveLUT.h"
+
+#include <units/length.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+using namespace wom;
+
+TEST(LiveLUT, Updates) {
+  LiveLUT<units::meter_t, units::meter_t> lut({ {5_m, 12.8_m}, {1_m, 9_m}, {21_m, 3_m} });
+  EXPECT_NEAR(lut.Estimate(3_m).value(), 10.9, 1e-9);
+
+  lut.Set(16_m, 7.1_m);
+  EXPECT_NEAR(lut.Estimate(8.3_m).value(), 11.09, 1e-9);
+
+  lut.Set(1_m, 10_m);
+  EXPECT_EQ(lut.GetPoints().size(), 4u);
+  EXPECT_NEAR(lut.Estimate(0_m).value(), 10, 1e-9);
+
+  lut.Remove(16_m);
+  lut.Remove(100_m);
+  EXPECT_EQ(lut.GetPoints().size(), 3u);
+  EXPECT_NEAR(lut.Estimate(13_m).value(), 7.9, 1e-9);
+
+  lut.SetPoints({});
+  EXPECT_NEAR(lut.Estimate(13_m).value(), 0, 1e-9);
+  EXPECT_EQ(lut.GetVersion(), 5u);
+}
+
+TEST(LiveLUT, ReadersSeeWholeSnapshots) {
+  // Every published table is y = k * x for some k, so a reader mixing two tables would see y(10) != 2 y(5).
+  LiveLUT<double, double> lut({ {0, 0}, {10, 10} });
+  std::atomic<bool> stop{false};
+  std::atomic<int> reads{0}, torn{0}, freedInUse{0};
+
+  // The table each reader is inside Read with, so retiring one of them can be caught.
+  std::atomic<const LUT<double, double> *> held[3]{ {nullptr}, {nullptr}, {nullptr} };
+  lut.SetRetireHook([&](const LUT<double, double> &table) {
+    for (auto &h : held)
+      if (h.load() == &table) freedInUse++;
+  });
+
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 3; r++) {
+    readers.emplace_back([&, r]() {
+      while (!stop.load()) {
+        bool consistent = lut.Read([&](const LUT<double, double> &table) {
+          held[r] = &table;
+          bool result = std::abs(table.Estimate(10) - 2 * table.Estimate(5)) < 1e-9;
+          held[r] = nullptr;
+          return result;
+        });
+        if (!consistent) torn++;
+        reads++;
+      }
+    });
+  }
+
+  for (int k = 2; k < 500; k++)
+    lut.SetPoints({ {0, 0}, {5, 5.0 * k}, {10, 10.0 * k} });
+  while (reads.load() < 1000) std::this_thread::yield();
+  stop = true;
+  for (auto &t : readers) t.join();
+
+  EXPECT_EQ(torn.load(), 0);
+  EXPECT_EQ(freedInUse.load(), 0);
+  EXPECT_NEAR(lut.Estimate(10), 4990, 1e-9);
+}
+
+TEST(LiveLUT, RetiresOnlyAfterReadersLeave) {
+  LiveLUT<double, double> lut({ {0, 0}, {10, 10} });
+  std::atomic<int> retired{0};
+  std::atomic<const LUT<double, double> *> lastRetired{nullptr};
+  lut.SetRetireHook([&](const LUT<double, double> &table) {
+    lastRetired = &table;
+    retired++;
+  });
+
+  std::atomic<const LUT<double, double> *> held{nullptr};
+  std::atomic<bool> release{false};
+  std::thread reader([&]() {
+    lut.Read([&](const LUT<double, double> &table) {
+      held = &table;
+      while (!release.load()) std::this_thread::yield();
+      return table.Estimate(5);
+    });
+  });
+  while (held.load() == nullptr) std::this_thread::yield();
+
+  // The writer publishes straight away, but must wait for the reader before freeing the old table.
+  std::thread writer([&]() { lut.Set(5, 50); });
+  while (lut.GetVersion() == 0) std::this_thread::yield();
+  EXPECT_NEAR(lut.Estimate(5), 50, 1e-9);
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_EQ(retired.load(), 0);
+
+  release = true;
+  reader.join();
+  writer.join();
+  EXPECT_EQ(retired.load(), 1);
+  EXPECT_EQ(lastRetired.load(), held.load());
+}
@@ -0,0 +1,34 @@
+#include <gtest/gtest.h>
+
+#include "MovingAverage.h"
+
+#include <frc/filter/LinearFilter.h>
+#include <units/length.h>
+
+#include <random>
+
+using namespace wom;
+
+TEST(MovingAverage, MatchesLinearFilter) {
+  std::mt19937 rng{4788};
+  std::normal_distribution<double> noise{0, 1};
+
+  MovingAverage<units::meter_t, 20> average;
+  auto filter = frc::LinearFilter<units::meter_t>::MovingAverage(20);
+  for (int i = 0; i < 10000; i++) {
+    units::meter_t sample{ 1e3 * std::sin(i * 0.01) + noise(rng) };
+    EXPECT_NEAR(average.Calculate(sample).value(), filter.Calculate(sample).value(), 1e-9) << i;
+  }
+
+  average.Reset();
+  filter.Reset();
+  EXPECT_NEAR(average.Calculate(4_m).value(), filter.Calculate(4_m).value(), 1e-12);
+  EXPECT_NEAR(average.Get().value(), 0.2, 1e-12);
+}
+
+TEST(MovingAverage, SingleSampleWindow) {
+  MovingAverage<double, 1> average;
+  EXPECT_EQ(average.Calculate(3), 3);
+  EXPECT_EQ(average.Calculate(-1), -1);
+  static_assert(MovingAverage<double, 1>::Window() == 1);
+}
@@ -0,0 +1,135 @@
+#include <gtest/gtest.h>
+
+#include "PID.h"
+#include "ScheduledPID.h"
+
+#include <units/length.h>
+#include <units/voltage.h>
+
+#include <chrono>
+#include <thread>
+
+using namespace wom;
+
+using conf_t = PIDConfig<units::radian, units::volt>;
+
+TEST(PID, SetGainsAppliesOnNextCalculate) {
+  conf_t config{ "/test/pid/gains/config", conf_t::kp_t{2} };
+  PIDController<units::radian, units::volt> pid{ "/test/pid/gains", config, 1_rad, PIDTelemetry::kOff };
+
+  EXPECT_NEAR(pid.Calculate(0_rad, 20_ms).value(), 2, 1e-12);
+
+  auto gains = pid.config.GetGains();
+  gains.kp = conf_t::kp_t{5};
+  pid.config.SetGains(gains);
+  EXPECT_NEAR(pid.Calculate(0_rad, 20_ms).value(), 5, 1e-12);
+}
+
+TEST(PID, TelemetryLevels) {
+  conf_t config{ "/test/pid/telemetry/config", conf_t::kp_t{1} };
+  PIDController<units::radian, units::volt> pid{ "/test/pid/telemetry", config, 0_rad, PIDTelemetry::kDecimated };
+  auto pv = nt::NetworkTableInstance::GetDefault().GetTable("/test/pid/telemetry")->GetEntry("pv");
+
+  // The first call publishes, then every kDefaultDecimation-th.
+  for (int i = 0; i < 25; i++) {
+    pid.Calculate(units::radian_t{(double)i}, 20_ms);
+    EXPECT_EQ(pv.GetDouble(-1), i / pid.kDefaultDecimation * pid.kDefaultDecimation) << i;
+  }
+
+  pid.SetTelemetry(PIDTelemetry::kDecimated, 3);
+  for (int i = 0; i < 10; i++) {
+    pid.Calculate(units::radian_t{100.0 + i}, 20_ms);
+    EXPECT_EQ(pv.GetDouble(-1), 100 + i / 3 * 3) << i;
+  }
+
+  pid.SetTelemetry(PIDTelemetry::kOff);
+  for (int i = 0; i < 10; i++) {
+    pid.Calculate(units::radian_t{200.0 + i}, 20_ms);
+    EXPECT_EQ(pv.GetDouble(-1), 109);
+  }
+
+  pid.SetTelemetry(PIDTelemetry::kFull);
+  pid.Calculate(300_rad, 20_ms);
+  EXPECT_EQ(pv.GetDouble(-1), 300);
+}
+
+TEST(PID, TelemetryStabilityUsesPassedGains) {
+  conf_t config{ "/test/pid/stable/config", conf_t::kp_t{1}, conf_t::ki_t{0}, conf_t::kd_t{0}, 0.01_rad };
+  PIDController<units::radian, units::volt> pid{ "/test/pid/stable", config, 0.5_rad };
+  auto stable = nt::NetworkTableInstance::GetDefault().GetTable("/test/pid/stable")->GetEntry("stable");
+
+  // A steady 0.5 rad error is outside the config's threshold, but inside the scheduled one.
+  auto gains = config.GetGains();
+  gains.stableThresh = 1_rad;
+  for (int i = 0; i < 30; i++)
+    pid.Calculate(0_rad, 20_ms, gains);
+
+  EXPECT_TRUE(stable.GetBoolean(false));
+  EXPECT_FALSE(pid.IsStable());
+  EXPECT_TRUE(pid.IsStable(1_rad));
+}
+
+TEST(PID, ConfigCopiesHaveTheirOwnGains) {
+  conf_t config{ "/test/pid/copies/config", conf_t::kp_t{2} };
+  conf_t copy = config;
+
+  auto gains = copy.GetGains();
+  gains.kp = conf_t::kp_t{3};
+  copy.SetGains(gains);
+
+  EXPECT_EQ(config.GetGains().kp.value(), 2);
+  EXPECT_EQ(copy.GetGains().kp.value(), 3);
+
+  // A copy of a config tuned over NT keeps the tuned gains, and doesn't write the old ones back.
+  auto kP = nt::NetworkTableInstance::GetDefault().GetTable("/test/pid/copies/config")->GetEntry("kP");
+  kP.SetDouble(7);
+  for (int i = 0; i < 100 && config.GetGains().kp.value() != 7; i++)
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  ASSERT_EQ(config.GetGains().kp.value(), 7);
+
+  conf_t another = config;
+  EXPECT_EQ(another.GetGains().kp.value(), 7);
+  EXPECT_EQ(kP.GetDouble(0), 7);
+  EXPECT_EQ(config.GetGains().kp.value(), 7);
+
+  // Every config on the path took the NT value; assigning one tuned since brings its gains along.
+  copy.SetGains(gains);
+  another = copy;
+  EXPECT_EQ(another.GetGains().kp.value(), 3);
+  EXPECT_EQ(kP.GetDouble(0), 7);
+  EXPECT_EQ(config.GetGains().kp.value(), 7);
+}
+
+TEST(PID, ScheduledOnProcessVariable) {
+  conf_t config{ "/test/pid/scheduled/config", conf_t::kp_t{100}, conf_t::ki_t{0}, conf_t::kd_t{0}, 0.1_rad };
+  LUTScheduledPIDController<units::radian, units::volt> pid{ "/test/pid/scheduled", config,
+    LUT<units::radian_t, conf_t::kp_t>{{ { 0_rad, conf_t::kp_t{2} }, { 1_rad, conf_t::kp_t{4} } }},
+    LUT<units::radian_t, conf_t::ki_t>{{ { 0_rad, conf_t::ki_t{0} } }},
+    LUT<units::radian_t, conf_t::kd_t>{{ { 0_rad, conf_t::kd_t{0} } }},
+    2_rad, PIDTelemetry::kOff };
+
+  // kP is 3 halfway along the table, and the config's kP is ignored.
+  EXPECT_NEAR(pid.GetGains(0.5_rad).kp.value(), 3, 1e-12);
+  EXPECT_NEAR(pid.GetGains(0.5_rad).stableThresh.value(), 0.1, 1e-12);
+  EXPECT_NEAR(pid.Calculate(0.5_rad, 20_ms).value(), 3 * 1.5, 1e-12);
+  EXPECT_NEAR(pid.Calculate(1.5_rad, 20_ms).value(), 4 * 0.5, 1e-12);
+}
+
+TEST(PID, ScheduledOnAnotherSignal) {
+  using kp_t = conf_t::kp_t;
+  using ki_t = conf_t::ki_t;
+  using kd_t = conf_t::kd_t;
+
+  // Arm gains against elevator height.
+  constexpr StaticLUT<units::meter_t, kp_t, 2> kP{{{ { 0_m, kp_t{1} }, { 2_m, kp_t{5} } }}};
+  constexpr StaticLUT<units::meter_t, ki_t, 1> kI{{{ { 0_m, ki_t{0} } }}};
+  constexpr StaticLUT<units::meter_t, kd_t, 2> kD{{{ { 0_m, kd_t{0} }, { 2_m, kd_t{1} } }}};
+
+  conf_t config{ "/test/pid/static/config" };
+  ScheduledPIDController<units::radian, units::volt, units::meter_t, decltype(kP), decltype(kI), decltype(kD)> pid{
+    "/test/pid/static", config, kP, kI, kD, 1_rad, PIDTelemetry::kOff };
+
+  EXPECT_NEAR(pid.Calculate(0_rad, 1_m, 20_ms).value(), 3, 1e-12);
+  // pv moved 0.5 rad in 0.5 s, so the derivative is 1 rad/s against kD 1.
+  EXPECT_NEAR(pid.Calculate(0.5_rad, 2_m, 500_ms).value(), 5 * 0.5 + 1 * 1, 1e-12);
+}
@@ -0,0 +1,77 @@
+#include <gtest/gtest.h>
+
+#include "PIDBank.h"
+
+#include <units/angle.h>
+#include <units/length.h>
+#include <units/velocity.h>
+#include <units/voltage.h>
+
+#include <random>
+
+using namespace wom;
+
+TEST(PIDBank, MatchesPIDController) {
+  using angle_conf_t = PIDConfig<units::radian, units::volt>;
+  using velocity_conf_t = PIDConfig<units::meters_per_second, units::volt>;
+  angle_conf_t angleConfig{ "/test/pidbank/angle", angle_conf_t::kp_t{4}, angle_conf_t::ki_t{0.5}, angle_conf_t::kd_t{0.1}, 0.05_rad, angle_conf_t::deriv_t{0.5}, 0.5_rad };
+  velocity_conf_t velocityConfig{ "/test/pidbank/velocity", velocity_conf_t::kp_t{2}, velocity_conf_t::ki_t{1}, velocity_conf_t::kd_t{0}, 0.1_mps };
+
+  PIDController<units::radian, units::volt> anglePID{ "/test/pidbank/angle", angleConfig };
+  PIDController<units::meters_per_second, units::volt> velocityPID{ "/test/pidbank/velocity", velocityConfig };
+  anglePID.SetWrap(360_deg);
+
+  PIDBank<2> bank;
+  auto angleLane = bank.GetLane<units::radian, units::volt>(0);
+  auto velocityLane = bank.GetLane<units::meters_per_second, units::volt>(1);
+  angleLane.Configure(angleConfig);
+  angleLane.SetWrap(360_deg);
+  velocityLane.Configure(velocityConfig);
+
+  std::mt19937 rng{4788};
+  std::uniform_real_distribution<double> angle{-7, 7}, speed{-3, 3}, noise{-0.02, 0.02};
+  std::bernoulli_distribution change{0.05}, idle{0.1};
+  units::radian_t anglePv = 0_rad;
+  units::meters_per_second_t speedPv = 0_mps;
+  units::second_t dt = 20_ms;
+
+  for (int tick = 0; tick < 2000; tick++) {
+    if (change(rng)) {
+      units::radian_t sp{ angle(rng) };
+      anglePID.SetSetpoint(sp);
+      angleLane.SetSetpoint(sp);
+    }
+    if (change(rng)) {
+      units::meters_per_second_t sp{ speed(rng) };
+      velocityPID.SetSetpoint(sp);
+      velocityLane.SetSetpoint(sp);
+    }
+
+    // A crude plant, so the loops settle and the stability checks see both outcomes.
+    anglePv += units::radian_t{ 0.1 * (anglePID.GetSetpoint() - anglePv).value() + noise(rng) };
+    speedPv += units::meters_per_second_t{ 0.2 * (velocityPID.GetSetpoint() - speedPv).value() + noise(rng) };
+
+    bool angleIdle = idle(rng);
+    angleLane.SetEnabled(!angleIdle);
+    angleLane.SetInput(anglePv);
+    velocityLane.SetInput(speedPv, 0.5_V);
+    bank.Calculate(dt);
+
+    if (!angleIdle) {
+      EXPECT_NEAR(angleLane.GetOutput().value(), anglePID.Calculate(anglePv, dt).value(), 1e-9) << tick;
+    } else {
+      EXPECT_EQ(angleLane.GetOutput().value(), 0);
+    }
+    EXPECT_NEAR(velocityLane.GetOutput().value(), velocityPID.Calculate(speedPv, dt, 0.5_V).value(), 1e-9) << tick;
+
+    EXPECT_NEAR(angleLane.GetError().value(), anglePID.GetError().value(), 1e-9);
+    EXPECT_EQ(angleLane.IsStable(), anglePID.IsStable()) << tick;
+    EXPECT_EQ(angleLane.IsStable(0.2_rad), anglePID.IsStable(0.2_rad)) << tick;
+    EXPECT_EQ(velocityLane.IsStable(), velocityPID.IsStable()) << tick;
+
+    if (tick % 500 == 499) {
+      anglePID.Reset();
+      angleLane.Reset();
+    }
+  }
+}
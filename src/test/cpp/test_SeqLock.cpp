@@ -0,0 +1,52 @@
+#include <gtest/gtest.h>
+
+#include "SeqLock.h"
+
+#include <array>
+#include <atomic>
+#include <thread>
+
+using namespace wom;
+
+TEST(SeqLock, LoadStoreUpdate) {
+  SeqLock<std::array<double, 3>> lock{ {{ 1, 2, 3 }} };
+  EXPECT_EQ(lock.Load()[1], 2);
+
+  lock.Store({{ 4, 5, 6 }});
+  lock.Update([](std::array<double, 3> &v) { v[2] = 7; });
+  auto v = lock.Load();
+  EXPECT_EQ(v[0], 4);
+  EXPECT_EQ(v[1], 5);
+  EXPECT_EQ(v[2], 7);
+  EXPECT_EQ(lock.GetVersion(), 3);
+}
+
+TEST(SeqLock, ReadersNeverSeeTornValues) {
+  // Every write sets all fields to the same value, so a reader that sees them differ caught a
+  // write halfway through.
+  SeqLock<std::array<double, 6>> lock;
+  std::atomic<bool> done{ false };
+  std::atomic<int> torn{ 0 };
+
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 2; r++) {
+    readers.emplace_back([&] {
+      while (!done) {
+        auto v = lock.Load();
+        for (double x : v) if (x != v[0]) torn++;
+      }
+    });
+  }
+
+  for (int i = 1; i <= 100000; i++) {
+    std::array<double, 6> v;
+    v.fill(i);
+    if (i % 2) lock.Store(v);
+    else lock.Update([&](std::array<double, 6> &current) { current = v; });
+  }
+  done = true;
+  for (auto &t : readers) t.join();
+
+  EXPECT_EQ(torn, 0);
+  EXPECT_EQ(lock.Load()[5], 100000);
+}
@@ -6,6 +6,8 @@
 
 #include <frc/simulation/DCMotorSim.h>
 
+#include <algorithm>
+#include <cmath>
 #include <fstream>
 
 using namespace wom;
@@ -154,4 +156,103 @@ using namespace wom;
 
 //     std::this_thread::sleep_for(std::chrono::milliseconds(20));
 //   }
-// }
\ No newline at end of file
+// }
+namespace {
+  class FakeVoltageController : public VoltageController {
+   public:
+    void SetVoltage(units::volt_t voltage) override { _voltage = voltage; }
+    units::volt_t GetVoltage() const override { return _voltage; }
+    void SetInverted(bool invert) override { _inverted = invert; }
+    bool GetInverted() const override { return _inverted; }
+
+   private:
+    units::volt_t _voltage{0};
+    bool _inverted = false;
+  };
+
+  class FakeEncoder : public Encoder {
+   public:
+    FakeEncoder(double ticksPerRotation) : Encoder(ticksPerRotation, 1, 0) {}
+    double GetEncoderRawTicks() const override { return ticks; }
+    double GetEncoderTickVelocity() const override { return tickVelocity; }
+    std::shared_ptr<sim::SimCapableEncoder> MakeSimEncoder() override { return nullptr; }
+
+    double ticks = 0, tickVelocity = 0;
+  };
+
+  class FakeGyro : public Gyro {
+   public:
+    void Calibrate() override {}
+    void Reset() override {}
+    double GetAngle() const override { return 0; }
+    double GetRate() const override { return 0; }
+    std::shared_ptr<sim::SimCapableGyro> MakeSimGyro() override { return nullptr; }
+  };
+
+  struct FakeSwerve {
+    FakeVoltageController driveMotors[4], turnMotors[4];
+    FakeEncoder driveEncoders[4]{ {1024}, {1024}, {1024}, {1024} }, turnEncoders[4]{ {1024}, {1024}, {1024}, {1024} };
+    FakeGyro gyro;
+
+    SwerveModuleConfig Module(int i, frc::Translation2d position) {
+      return SwerveModuleConfig{
+        position,
+        Gearbox{ &driveMotors[i], &driveEncoders[i], DCMotor::NEO(1).WithReduction(6.75) },
+        Gearbox{ &turnMotors[i], &turnEncoders[i], DCMotor::NEO(1).WithReduction(12.8) },
+        nullptr,
+        4_in / 2
+      };
+    }
+
+    SwerveDriveConfig config{
+      "/test/swerve",
+      // Small gains, so the outputs stay inside the modules' voltage clamps (see PIDBankMatchesControllers).
+      { "/test/swerve/pid/angle/config", 1_V / 90_deg, 0_V / (1_deg * 1_s), 0.001_V / (1_deg / 1_s) },
+      { "/test/swerve/pid/velocity/config", 1_V / 1_mps, 0.1_V / 1_m },
+      { Module(0, { 1_m, 1_m }), Module(1, { 1_m, -1_m }), Module(2, { -1_m, -1_m }), Module(3, { -1_m, 1_m }) },
+      &gyro,
+      { "/test/swerve/pid/heading/config", (180_deg / 1_s) / 45_deg },
+      { "/test/swerve/pid/position/config", 4_mps / 1_m },
+      50_kg
+    };
+
+    SwerveDrive drive{ config, frc::Pose2d{} };
+  };
+}
+
+TEST(SwerveDrive, PIDBankMatchesControllers) {
+  FakeSwerve controllers, banked;
+  banked.drive.UsePIDBank(true);
+
+  // Gains, speeds and the acceleration limit keep every output clear of the modules' clamps, so the
+  // voltages compared are the PID outputs themselves rather than the limits.
+  for (FakeSwerve *swerve : { &controllers, &banked }) {
+    swerve->drive.SetAccelerationLimit(1000_mps / 1_s);
+    swerve->drive.SetVelocity(frc::ChassisSpeeds{ 0.2_mps, 0.1_mps, 0.2_rad_per_s });
+  }
+
+  double largest = 0;
+  for (int tick = 0; tick < 25; tick++) {
+    for (FakeSwerve *swerve : { &controllers, &banked }) {
+      for (int i = 0; i < 4; i++) {
+        swerve->turnEncoders[i].ticks = 40.0 * tick + 100 * i;
+        swerve->driveEncoders[i].tickVelocity = 200.0 * tick - 50 * i;
+      }
+      swerve->drive.OnUpdate(20_ms);
+    }
+
+    for (int i = 0; i < 4; i++) {
+      double drive = controllers.driveMotors[i].GetVoltage().value();
+      double turn = controllers.turnMotors[i].GetVoltage().value();
+      ASSERT_LT(std::abs(drive), 10) << tick << " " << i;
+      ASSERT_LT(std::abs(turn), 7 - 0.7 * std::abs(drive)) << tick << " " << i;
+      largest = std::max({ largest, std::abs(drive), std::abs(turn) });
+
+      EXPECT_NEAR(banked.driveMotors[i].GetVoltage().value(), drive, 1e-9) << tick << " " << i;
+      EXPECT_NEAR(banked.turnMotors[i].GetVoltage().value(), turn, 1e-9) << tick << " " << i;
+    }
+  }
+
+  // The loops did something.
+  EXPECT_GT(largest, 0.1);
+}
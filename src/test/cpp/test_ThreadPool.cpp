@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+
+#include "ThreadPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+using namespace wom;
+
+TEST(ThreadPool, RunsEveryIndexOnce) {
+  ThreadPool pool{3};
+  for (size_t count : { 0, 1, 2, 7, 1000, 100000 }) {
+    std::vector<std::atomic<int>> hits(count);
+    pool.ParallelFor(count, [&](size_t i) { hits[i]++; });
+    for (size_t i = 0; i < count; i++)
+      ASSERT_EQ(hits[i], 1) << count << " " << i;
+  }
+}
+
+TEST(ThreadPool, WorkerIndicesDoNotOverlap) {
+  ThreadPool pool{3};
+  std::vector<std::atomic<int>> inUse(pool.Concurrency());
+  std::atomic<bool> overlapped{false};
+  pool.ParallelFor(200, [&](size_t, size_t worker) {
+    if (inUse[worker]++ != 0) overlapped = true;
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+    inUse[worker]--;
+  });
+  EXPECT_FALSE(overlapped);
+}
+
+TEST(ThreadPool, StealsUnevenWork) {
+  ThreadPool pool{3};
+  // All the slow items are in the first thread's share; the others must steal them.
+  std::vector<std::atomic<int>> byWorker(pool.Concurrency());
+  pool.ParallelFor(64, [&](size_t i, size_t worker) {
+    if (i < 16) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    byWorker[worker]++;
+  });
+  int total = 0, busy = 0;
+  for (auto &n : byWorker) {
+    total += n;
+    busy += n > 0;
+  }
+  EXPECT_EQ(total, 64);
+  EXPECT_GT(busy, 1);
+}
+
+TEST(ThreadPool, NestedCallsRunSerially) {
+  ThreadPool pool{2};
+  std::atomic<int> total{0};
+  pool.ParallelFor(8, [&](size_t) {
+    pool.ParallelFor(8, [&](size_t) { total++; });
+  });
+  EXPECT_EQ(total, 64);
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "Grid.h"
+
+#include <units/length.h>
+#include <units/time.h>
+
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <random>
+
+// Shared grid fixtures for the grid planner tests and benchmarks.
+
+using grid_t = wom::DiscretisedOccupancyGrid<units::meter, units::meter>;
+using path_t = std::deque<grid_t::GridPathNode<units::second>>;
+using cost_per_m_t = grid_t::converting_unit<units::meter, units::second>;
+
+inline grid_t RandomGrid(std::mt19937 &rng, int size, double density) {
+  grid_t grid{ 0_m, size * 1_m, 0_m, size * 1_m, (size_t)size, (size_t)size };
+  std::bernoulli_distribution occupied{density};
+  for (int x = 0; x < size; x++)
+    for (int y = 0; y < size; y++)
+      grid.Set({x, y}, occupied(rng));
+  return grid;
+}
+
+inline Eigen::Vector2i RandomFreeCell(std::mt19937 &rng, grid_t &grid, int size) {
+  std::uniform_int_distribution<int> coord{0, size - 1};
+  Eigen::Vector2i idx;
+  do {
+    idx = { coord(rng), coord(rng) };
+  } while (grid.Get(idx));
+  return idx;
+}
+
+// Perfect maze of corridors one cell wide, carved by a randomised depth-first search.
+inline grid_t MazeGrid(std::mt19937 &rng, int size) {
+  grid_t grid{ 0_m, size * 1_m, 0_m, size * 1_m, (size_t)size, (size_t)size };
+  grid.Fill(true);
+
+  std::vector<Eigen::Vector2i> stack{ {1, 1} };
+  grid.Set({1, 1}, false);
+  std::array<Eigen::Vector2i, 4> dirs{ Eigen::Vector2i{2, 0}, {-2, 0}, {0, 2}, {0, -2} };
+  while (!stack.empty()) {
+    Eigen::Vector2i cell = stack.back();
+    std::shuffle(dirs.begin(), dirs.end(), rng);
+    bool carved = false;
+    for (auto d : dirs) {
+      Eigen::Vector2i next = cell + d;
+      if (next.x() > 0 && next.y() > 0 && next.x() < size - 1 && next.y() < size - 1 && grid.Get(next)) {
+        grid.Set(cell + d / 2, false);
+        grid.Set(next, false);
+        stack.push_back(next);
+        carved = true;
+        break;
+      }
+    }
+    if (!carved) stack.pop_back();
+  }
+  return grid;
+}
+
+// Mostly open, with a few wall segments and blocks like a game field.
+inline grid_t FieldGrid(int size) {
+  grid_t grid{ 0_m, size * 1_m, 0_m, size * 1_m, (size_t)size, (size_t)size };
+  for (int i = 0; i < size * 3 / 5; i++) {
+    grid.Set({size / 3, i}, true);
+    grid.Set({2 * size / 3, size - 1 - i}, true);
+  }
+  for (int x = size / 2 - size / 10; x <= size / 2 + size / 10; x++)
+    for (int y = size / 2 - size / 10; y <= size / 2 + size / 10; y++)
+      grid.Set({x, y}, true);
+  return grid;
+}
+
+struct LegacyAStarNode {
+  Eigen::Vector2i position;
+  std::shared_ptr<LegacyAStarNode> parent;
+  units::second_t gScore;
+  units::second_t fScore;
+};
+
+// The original shared_ptr / linear-scan implementation of AStarStrict, kept as a reference
+// for correctness (test_Grid) and to measure the speedup of the indexed-heap search (bench_Grid).
+inline path_t LegacyAStarStrict(grid_t &grid, Eigen::Vector2i start, Eigen::Vector2i end, cost_per_m_t dxCost, cost_per_m_t dyCost) {
+  using cost_t = units::second_t;
+  using node_t = std::shared_ptr<LegacyAStarNode>;
+
+  std::vector<node_t> allNodes;
+  allNodes.push_back(std::make_shared<LegacyAStarNode>(
+    start, nullptr, cost_t{0}, grid.Cost<units::second>(start, end, dxCost, dyCost)
+  ));
+
+  std::vector<node_t> openSet;
+  openSet.push_back(allNodes[0]);
+
+  while (!openSet.empty()) {
+    auto currentIt = std::min_element(openSet.cbegin(), openSet.cend(), [](auto a, auto b) { return a->fScore < b->fScore; });
+    node_t current = *currentIt;
+    openSet.erase(currentIt);
+    if (current->position == end) {
+      path_t queue;
+      queue.push_front({ grid.CenterOf(current->position), current->gScore });
+      while (current->parent) {
+        queue.push_front({ grid.CenterOf(current->parent->position), current->parent->gScore });
+        current = current->parent;
+      }
+      return queue;
+    }
+    for (int dx = -1; dx <= 1; dx++) {
+      for (int dy = -1; dy <= 1; dy++) {
+        Eigen::Vector2i newPos = current->position + Eigen::Vector2i{ dx, dy };
+        auto neighbourIt = std::find_if(allNodes.cbegin(), allNodes.cend(), [newPos](auto node) { return node->position == newPos; });
+        if (neighbourIt == allNodes.cend()) {
+          allNodes.push_back(std::make_shared<LegacyAStarNode>(newPos, nullptr, cost_t{1e9}, cost_t{1e9}));
+          neighbourIt = allNodes.cend() - 1;
+        }
+        node_t neighbour = *neighbourIt;
+
+        if (newPos != current->position && !grid.Get(newPos)) {
+          cost_t tentative = current->gScore + grid.Cost<units::second>(current->position, newPos, dxCost, dyCost);
+          if (tentative < neighbour->gScore) {
+            neighbour->parent = current;
+            neighbour->gScore = tentative;
+            neighbour->fScore = tentative + grid.Cost<units::second>(newPos, end, dxCost, dyCost);
+            if (std::find(openSet.cbegin(), openSet.cend(), neighbour) == openSet.cend())
+              openSet.push_back(neighbour);
+          }
+        }
+      }
+    }
+  }
+  return path_t{};
+}